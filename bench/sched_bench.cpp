@@ -0,0 +1,511 @@
+/*
+ * sched_bench.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <scheduler.h>
+#include <print.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/time.h>
+
+/**
+ * Host microbenchmarks for the kernel, built on the host port (see the README). Every scheduling algorithm is driven
+ * through schedule() directly - no context switches - over a sweep of task counts, shares of tasks that are off the
+ * ready set (sleeping, or blocked until a simulated notification) and priority distributions. The UART TX path,
+ * the formatters and the lottery draw against the interval rebuild it replaced are measured as well. Every case is
+ * run a few times and the fastest pass is kept, which takes most of the noise of a shared machine out. Each result
+ * is one JSON object per line on stdout; tools/bench_compare.py diffs two runs and fails on regressions.
+ *
+ *     kernel_bench [decisions per case]
+ */
+
+/**
+ * Allocation counter - every heap allocation in the process goes through here
+ */
+
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+	++allocations;
+	if (void *p = std::malloc(size != 0 ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+using bench_clock = std::chrono::steady_clock;
+
+static std::uint64_t elapsed_ns(bench_clock::time_point start, bench_clock::time_point stop) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+}
+
+/**
+ * Cost of reading the clock twice, taken off every sample
+ */
+
+static std::uint64_t clock_overhead(void) {
+	std::uint64_t best = ~std::uint64_t(0);
+	for (int i = 0; i < 10000; ++i) {
+		const auto start = bench_clock::now();
+		const auto stop = bench_clock::now();
+		best = std::min(best, elapsed_ns(start, stop));
+	}
+
+	return best;
+}
+
+static std::uint64_t overhead = 0;
+
+static const int passes = 3;
+
+/**
+ * Workload description
+ */
+
+enum class priorities : std::uint8_t {
+	flat,		// Every task at priority 1
+	linear,		// Priorities 1 to 8 in turn
+	skewed		// One task at priority 15, the rest at 1
+};
+
+static const char *priorities_name(priorities p) {
+	switch (p) {
+		case priorities::flat: return "flat";
+		case priorities::linear: return "linear";
+		case priorities::skewed: return "skewed";
+	}
+
+	return "";
+}
+
+static std::uint8_t priority_of(priorities p, std::size_t i) {
+	switch (p) {
+		case priorities::flat: return 1;
+		case priorities::linear: return static_cast<std::uint8_t>(1 + i % 8);
+		case priorities::skewed: return (i == 0) ? 15 : 1;
+	}
+
+	return 1;
+}
+
+struct workload {
+	std::size_t tasks;
+	std::uint8_t off_percent;	// Share of tasks that leave the ready set whenever they run - half sleep, half block
+	priorities prio;
+	std::size_t decisions;
+};
+
+/**
+ * What a task does once it has been picked
+ */
+
+enum class role : std::uint8_t {
+	spin,		// Stays ready
+	sleeper,	// Sleeps (periodic tasks wait for their next release)
+	blocker		// Blocks until the benchmark notifies it
+};
+
+template <scheduling_algorithms alg>
+struct algorithm_name;
+
+template <> struct algorithm_name<scheduling_algorithms::round_robin> { static constexpr const char *value = "round_robin"; };
+template <> struct algorithm_name<scheduling_algorithms::lottery> { static constexpr const char *value = "lottery"; };
+template <> struct algorithm_name<scheduling_algorithms::stride> { static constexpr const char *value = "stride"; };
+template <> struct algorithm_name<scheduling_algorithms::edf> { static constexpr const char *value = "edf"; };
+
+static std::int16_t spin(void) {
+	for (;;);
+	return 0;
+}
+
+/**
+ * Results of one pass over a workload
+ */
+
+struct decision_stats {
+	double ns_mean;
+	std::uint32_t ns_p50;
+	std::uint32_t ns_p99;
+	std::uint32_t ns_max;
+	double allocs;
+	double off;
+	double idle;
+};
+
+/**
+ * Runs one workload through schedule() on a fresh scheduler
+ */
+
+template <scheduling_algorithms alg>
+static decision_stats measure_schedule(const workload &w) {
+	auto *s = new scheduler<alg>();
+
+	const std::size_t hold = w.tasks * 8;	// Ticks spent off the ready set - long enough that the share stays put
+	const std::size_t off = w.tasks * w.off_percent / 100;
+
+	std::vector<task *> tasks;
+	std::unordered_map<const task *, role> roles;
+
+	for (std::size_t i = 0; i < w.tasks; ++i) {
+		task proto(spin, 32, priority_of(w.prio, i));
+		if (alg == scheduling_algorithms::edf) {
+			const std::uint16_t period = static_cast<std::uint16_t>(hold + i);
+			proto.set_timing(period, 1, period);
+		}
+
+		task *t = s->add_task(proto);	// Workloads stop at MAX_TASKS, so there is always a slot
+		tasks.push_back(t);
+		roles[t] = (i < off / 2) ? role::sleeper : (i < off) ? role::blocker : role::spin;
+	}
+
+	std::deque<std::pair<task *, std::size_t>> blocked;
+	std::vector<std::uint32_t> samples(w.decisions);
+	std::size_t allocs = 0, idle = 0, off_samples = 0, off_total = 0;
+
+	const std::size_t warmup = w.decisions / 10;
+	for (std::size_t d = 0; d < warmup + w.decisions; ++d) {
+		const std::size_t before = allocations;
+		const auto start = bench_clock::now();
+		s->catch_up(1);	// Every decision is a tick, as with the watchdog interval
+		task &next = s->schedule();
+		const auto stop = bench_clock::now();
+
+		if (d >= warmup) {
+			const std::uint64_t ns = elapsed_ns(start, stop);
+			samples[d - warmup] = static_cast<std::uint32_t>((ns > overhead) ? ns - overhead : 0);
+			allocs += allocations - before;
+			if (&next == &task::idle_hook) ++idle;
+
+			if (d % 61 == 0) {	// Sample the share that is actually off the ready set - 61 keeps clear of the hold period
+				for (task *t : tasks) off_total += t->sleeping() || t->blocking();
+				++off_samples;
+			}
+		}
+
+		// Act out the picked task's role
+		if (&next != &task::idle_hook) {
+			switch (roles[&next]) {
+				case role::spin:
+					// A spinner's job ends at its deadline - without that boundary its deadline would stay in the
+					// past and keep it ahead of every task that has moved on to its next period
+					if (next.periodic() && s->get_tick_count() >= next.absolute_deadline()) s->next_period();
+					break;
+				case role::sleeper:
+					// Not next_period(), even under EDF - with the spinners soaking up every tick, a job released
+					// with a fresh deadline only gets picked close to it, so it would hardly ever sleep
+					s->sleep(hold);
+					break;
+				case role::blocker:
+					s->block();
+					blocked.emplace_back(&next, d + hold);
+					break;
+			}
+		}
+
+		// Notifications come in once a blocked task has waited its turn
+		while (!blocked.empty() && blocked.front().second <= d) {
+			s->unblock(*blocked.front().first);
+			blocked.pop_front();
+		}
+	}
+
+	for (task *t : tasks) s->cleanup(*t);
+	delete s;
+
+	std::uint64_t total = 0;
+	for (std::uint32_t ns : samples) total += ns;
+
+	std::sort(samples.begin(), samples.end());
+	const std::size_t n = samples.size();
+
+	decision_stats stats = {
+		static_cast<double>(total) / n, samples[n / 2], samples[n * 99 / 100], samples[n - 1],
+		static_cast<double>(allocs) / n,
+		off_samples ? static_cast<double>(off_total) / (off_samples * w.tasks) : 0.0,
+		static_cast<double>(idle) / n
+	};
+
+	return stats;
+}
+
+/**
+ * Keeps the fastest pass over a workload and prints its line - allocations are taken from the worst pass
+ */
+
+template <scheduling_algorithms alg>
+static void bench_schedule(const workload &w) {
+	decision_stats best = measure_schedule<alg>(w);
+
+	for (int i = 1; i < passes; ++i) {
+		const decision_stats stats = measure_schedule<alg>(w);
+		const double allocs = std::max(best.allocs, stats.allocs);
+		if (stats.ns_mean < best.ns_mean) best = stats;
+		best.allocs = allocs;
+	}
+
+	std::printf("{\"suite\": \"schedule\", \"algorithm\": \"%s\", \"tasks\": %zu, \"off_percent\": %u, "
+			"\"priorities\": \"%s\", \"decisions\": %zu, \"ns_mean\": %.1f, \"ns_p50\": %u, \"ns_p99\": %u, "
+			"\"ns_max\": %u, \"allocs_per_decision\": %.3f, \"measured_off\": %.3f, \"idle_share\": %.3f}\n",
+			algorithm_name<alg>::value, w.tasks, w.off_percent, priorities_name(w.prio), w.decisions,
+			best.ns_mean, best.ns_p50, best.ns_p99, best.ns_max, best.allocs, best.off, best.idle);
+}
+
+/**
+ * The lottery draw as it stood before the ticket index: every decision walked all tasks, rebuilt a vector of
+ * cumulative ticket intervals and binary searched it with std::upper_bound. It is kept here only as the yardstick
+ * the index is measured against.
+ */
+
+class rebuild_lottery {
+public:
+	explicit rebuild_lottery(std::vector<task> &tasks) : tasks(tasks) { }
+
+	task &schedule(void) {
+		std::vector<std::uint16_t> intervals;
+		intervals.reserve(this->tasks.size() + 1);
+		intervals.push_back(0);
+
+		std::uint16_t left = 0;
+		for (task &t : this->tasks) {
+			t.update();
+			if (!t.sleeping() && !t.blocking()) left += t.get_priority();
+			intervals.push_back(left);
+		}
+
+		if (left == 0) return task::idle_hook;
+
+		const std::uint32_t roll = static_cast<std::uint32_t>((static_cast<std::uint64_t>(this->next()) * left) >> 32);
+		auto it = std::upper_bound(intervals.begin(), intervals.end(), roll);
+		return this->tasks[it - (intervals.begin() + 1)];
+	}
+
+private:
+	std::uint32_t next(void) {	// xorshift32, as cheap as the kernel's generator
+		this->seed ^= this->seed << 13;
+		this->seed ^= this->seed >> 17;
+		this->seed ^= this->seed << 5;
+		return this->seed;
+	}
+
+	std::vector<task> &tasks;
+	std::uint32_t seed = 0x2545F491;
+};
+
+/**
+ * Times a run of decisions - the fastest of the passes is kept, allocations are taken from the worst
+ */
+
+template <class Pick>
+static decision_stats time_draws(std::size_t decisions, Pick pick) {
+	decision_stats best = { };
+	std::vector<std::uint32_t> samples(decisions);
+
+	for (int pass = 0; pass < passes; ++pass) {
+		const std::size_t before = allocations;
+
+		for (std::size_t d = 0; d < decisions; ++d) {
+			const auto start = bench_clock::now();
+			pick();
+			const auto stop = bench_clock::now();
+
+			const std::uint64_t ns = elapsed_ns(start, stop);
+			samples[d] = static_cast<std::uint32_t>((ns > overhead) ? ns - overhead : 0);
+		}
+
+		std::uint64_t total = 0;
+		for (std::uint32_t ns : samples) total += ns;
+		std::sort(samples.begin(), samples.end());
+
+		const double mean = static_cast<double>(total) / decisions;
+		const double allocs = std::max(best.allocs, static_cast<double>(allocations - before) / decisions);
+		if (pass == 0 || mean < best.ns_mean) {
+			best.ns_mean = mean;
+			best.ns_p50 = samples[decisions / 2];
+			best.ns_p99 = samples[decisions * 99 / 100];
+			best.ns_max = samples[decisions - 1];
+		}
+		best.allocs = allocs;
+	}
+
+	return best;
+}
+
+/**
+ * Lottery draw, ticket index against the per-decision rebuild, on the same task set. Tasks that are off the ready
+ * set are created blocked and stay that way, so both sides see the same pool every time.
+ */
+
+static void bench_lottery_draw(std::size_t tasks, std::uint8_t off_percent, std::size_t decisions) {
+	const std::size_t off = tasks * off_percent / 100;
+
+	std::vector<task> pool;
+	pool.reserve(tasks);
+	for (std::size_t i = 0; i < tasks; ++i) pool.emplace_back(spin, 32, priority_of(priorities::linear, i), i < off);
+
+	auto *s = new scheduler<scheduling_algorithms::lottery>();
+	std::vector<task *> added;
+	for (const task &t : pool) added.push_back(s->add_task(t));
+
+	rebuild_lottery rebuild(pool);
+	const decision_stats before = time_draws(decisions, [&] { rebuild.schedule(); });
+	const decision_stats after = time_draws(decisions, [&] { s->catch_up(1); s->schedule(); });
+
+	for (task *t : added) s->cleanup(*t);
+	delete s;
+
+	const char *const impl[] = { "rebuild", "index" };
+	const decision_stats *const stats[] = { &before, &after };
+	for (int i = 0; i < 2; ++i) {
+		std::printf("{\"suite\": \"lottery_draw\", \"impl\": \"%s\", \"tasks\": %zu, \"off_percent\": %u, "
+				"\"decisions\": %zu, \"ns_mean\": %.1f, \"ns_p50\": %u, \"ns_p99\": %u, \"ns_max\": %u, "
+				"\"allocs_per_decision\": %.3f}\n",
+				impl[i], tasks, off_percent, decisions, stats[i]->ns_mean, stats[i]->ns_p50, stats[i]->ns_p99,
+				stats[i]->ns_max, stats[i]->allocs);
+	}
+}
+
+/**
+ * UART transmit path - bytes go through the TX ring and the TXIFG handler into a sink that drops them
+ */
+
+static std::size_t sent = 0;
+
+static void count_byte(char) {
+	++sent;
+}
+
+static void bench_uart(std::size_t writes) {
+	static const char line[] = "printer1: 12345 ticks, stack usage 0042 words\r\n";
+	const std::size_t length = sizeof(line) - 1;
+
+	host_uart_transmit = count_byte;
+
+	const std::size_t before = allocations;
+	double ns = 0;
+
+	for (int pass = 0; pass < passes; ++pass) {
+		sent = 0;
+
+		const auto start = bench_clock::now();
+		for (std::size_t i = 0; i < writes; ++i) uart_write(line, length);
+		const auto stop = bench_clock::now();
+
+		const double pass_ns = static_cast<double>(elapsed_ns(start, stop));
+		if (pass == 0 || pass_ns < ns) ns = pass_ns;
+	}
+
+	std::printf("{\"suite\": \"uart\", \"case\": \"uart_write\", \"bytes\": %zu, \"ns_per_byte\": %.2f, "
+			"\"bytes_per_s\": %.0f, \"allocs_per_write\": %.3f}\n",
+			sent, ns / sent, sent * 1e9 / ns, static_cast<double>(allocations - before) / (writes * passes));
+}
+
+/**
+ * Formatters - the compile-time parsed path against uart_printf(), and thread_info::to_string()
+ */
+
+template <class Fn>
+static void bench_format(const char *name, std::size_t calls, Fn fn) {
+	host_uart_transmit = count_byte;
+
+	const std::size_t before = allocations;
+	double ns = 0;
+
+	for (int pass = 0; pass < passes; ++pass) {
+		const auto start = bench_clock::now();
+		for (std::size_t i = 0; i < calls; ++i) fn(i);
+		const auto stop = bench_clock::now();
+
+		const double pass_ns = static_cast<double>(elapsed_ns(start, stop));
+		if (pass == 0 || pass_ns < ns) ns = pass_ns;
+	}
+
+	std::printf("{\"suite\": \"format\", \"case\": \"%s\", \"calls\": %zu, \"ns_per_call\": %.1f, "
+			"\"allocs_per_call\": %.3f}\n",
+			name, calls, ns / calls, static_cast<double>(allocations - before) / (calls * passes));
+}
+
+int main(int argc, char **argv) {
+	const std::size_t decisions = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+	// The watchdog tick would only add signal noise to the samples - schedule() is called directly
+	struct itimerval stop = { };
+	setitimer(ITIMER_REAL, &stop, nullptr);
+
+	overhead = clock_overhead();
+
+	static const std::size_t task_counts[] = { 8, 16, 32, 64, 128 };
+	static const std::uint8_t off_percents[] = { 0, 25, 50, 90 };
+	static const priorities distributions[] = { priorities::flat, priorities::linear, priorities::skewed };
+
+	for (std::size_t tasks : task_counts) {
+		if (tasks > MAX_TASKS) continue;
+
+		for (std::uint8_t off : off_percents) {
+			for (priorities prio : distributions) {
+				const workload w = { tasks, off, prio, decisions };
+				bench_schedule<scheduling_algorithms::round_robin>(w);
+				bench_schedule<scheduling_algorithms::lottery>(w);
+				bench_schedule<scheduling_algorithms::stride>(w);
+				bench_schedule<scheduling_algorithms::edf>(w);
+			}
+		}
+	}
+
+	static const std::size_t draw_counts[] = { 8, 32, 128 };
+	for (std::size_t tasks : draw_counts) {
+		if (tasks > MAX_TASKS) continue;
+
+		bench_lottery_draw(tasks, 0, decisions);
+		bench_lottery_draw(tasks, 25, decisions);
+	}
+
+	_enable_interrupt();	// The TX ring drains through its interrupt handler
+
+	bench_uart(decisions / 10);
+
+	bench_format("uart_format", decisions, [](std::size_t i) {
+		uart_format(format_string("printer1: %u\r\n"), static_cast<unsigned>(i));
+	});
+
+	bench_format("uart_printf", decisions, [](std::size_t i) {
+		uart_printf(const_cast<char *>("printer1: %u\r\n"), static_cast<unsigned>(i));
+	});
+
+	bench_format("to_string", decisions, [](std::size_t) {
+		char buf[128];
+		task::idle_hook.get_state().to_string(buf, sizeof(buf));
+	});
+
+	return 0;
+}
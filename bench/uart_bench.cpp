@@ -0,0 +1,160 @@
+/*
+ * uart_bench.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <scheduler.h>
+#include <print.h>
+#include <host_port.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+
+#include <time.h>
+
+/**
+ * The UART TX path under contention, on the host port's simulated USCI. Two writer tasks push distinct alphabets
+ * through uart_write() - one of them from an interrupts-off section, which it checks is still off afterwards - while
+ * a third feeds bytes into RXD, so the RX echo competes for the TX ring as a second producer. The sink checks that
+ * each writer's bytes come out complete and in order; echo bytes may be dropped when the ring is full, never made up.
+ *
+ *     kernel_uart [line bytes per tick] [bytes per writer]
+ *
+ * 0 bytes per tick (the default) lets the line take everything at once, so the run is bound by the kernel and the
+ * ISR; 22 is about 115200 baud at the default tick. One JSON line goes to stderr - stdout is the line - with the
+ * throughput and the process CPU time spent per byte sent. Exits non-zero if a stream came out wrong.
+ */
+
+extern scheduler<scheduling_algorithms::lottery> os;
+
+void driver_init(void) { }
+
+using bench_clock = std::chrono::steady_clock;
+
+struct stream {
+	char first;
+	std::size_t sent;		// Bytes handed to uart_write()
+	std::size_t seen;		// Bytes that reached the line
+	bool done;
+};
+
+static stream upper = { 'A', 0, 0, false };
+static stream lower = { 'a', 0, 0, false };
+static std::size_t target = 0;
+static std::size_t injected = 0;
+static std::size_t echoed = 0;
+static std::size_t stray = 0;
+static bool gie_lost = false;
+
+static bench_clock::time_point start;
+static std::uint64_t cpu_start = 0;
+
+static std::uint64_t cpu_ns(void) {
+	timespec now;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+	return static_cast<std::uint64_t>(now.tv_sec) * 1000000000u + now.tv_nsec;
+}
+
+/**
+ * The line - sorts each byte back into its stream
+ */
+
+static void receive_line(char c) {
+	if (c >= 'A' && c <= 'Z') {
+		if (c != upper.first + static_cast<char>(upper.seen++ % 26)) ++stray;
+	} else if (c >= 'a' && c <= 'z') {
+		if (c != lower.first + static_cast<char>(lower.seen++ % 26)) ++stray;
+	} else if (c >= '0' && c <= '9') {
+		++echoed;
+	} else {
+		++stray;
+	}
+}
+
+/**
+ * Writes the stream in runs of 1 to 40 bytes, so runs wrap the ring and split across reservations
+ */
+
+static void write_stream(stream &s, bool interrupts_off) {
+	char run[40];
+
+	for (std::size_t length = 1; s.sent < target; length = length % sizeof(run) + 1) {
+		const std::size_t n = std::min(length, target - s.sent);
+		for (std::size_t i = 0; i < n; ++i) run[i] = s.first + static_cast<char>((s.sent + i) % 26);
+
+		if (interrupts_off) {
+			_disable_interrupt();
+			uart_write(run, n);
+			if (_get_interrupt_state() & GIE) gie_lost = true;	// wait() has to give the section back as it found it
+			_enable_interrupt();
+		} else {
+			uart_write(run, n);
+		}
+
+		s.sent += n;
+	}
+
+	s.done = true;
+}
+
+static std::int16_t upper_writer(void) {
+	write_stream(upper, false);
+	os.ret();
+	return 0;
+}
+
+static std::int16_t lower_writer(void) {
+	write_stream(lower, true);
+	os.ret();
+	return 0;
+}
+
+/**
+ * Feeds RXD a few bytes a tick while the writers run, then waits for the line to drain and reports
+ */
+
+static std::int16_t feeder(void) {
+	while (!upper.done || !lower.done) {
+		for (int i = 0; i < 4; ++i) {
+			_disable_interrupt();
+			host_uart_receive(static_cast<char>('0' + injected++ % 10));
+			_enable_interrupt();	// The RX interrupt is taken here, echo and all
+		}
+
+		os.sleep(1);
+	}
+
+	while (!uart_idle()) os.sleep(1);
+
+	const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count());
+	const double cpu = static_cast<double>(cpu_ns() - cpu_start);
+	const std::size_t bytes = upper.seen + lower.seen + echoed;
+
+	const bool ok = upper.seen == target && lower.seen == target && echoed <= injected && stray == 0 && !gie_lost;
+
+	std::fprintf(stderr, "{\"suite\": \"uart_line\", \"line_bytes_per_tick\": %zu, \"bytes\": %zu, \"echoed\": %zu, "
+			"\"injected\": %zu, \"bytes_per_s\": %.0f, \"cpu_ns_per_byte\": %.1f, \"ok\": %s}\n",
+			host_uart_line_bytes, bytes, echoed, injected, bytes * 1e9 / ns, cpu / bytes, ok ? "true" : "false");
+	std::exit(ok ? 0 : 1);
+}
+
+int main(int argc, char **argv) {
+	host_uart_line_bytes = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 0;
+	target = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : (host_uart_line_bytes ? 8000 : 400000);
+
+	host_uart_transmit = receive_line;
+	uart_init();
+
+	os.add_task(upper_writer, 64, 1);
+	os.add_task(lower_writer, 64, 1);
+	os.add_task(feeder, 64, 1);
+
+	start = bench_clock::now();
+	cpu_start = cpu_ns();
+	os.start();
+}
@@ -0,0 +1,81 @@
+/*
+ * yield_bench.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <scheduler.h>
+#include <print.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+
+#include <sys/time.h>
+
+/**
+ * Round trip of a voluntary switch on the host port. A few tasks do nothing but os.suspend(), so every switch is a
+ * yield - the tick is stopped. Build it twice to compare the watchdog flag path with the system call path:
+ *
+ *     kernel_yield [yields]					- WDTIFG raised, the switch taken through preempt()
+ *     kernel_yield_trap [yields]				- the same with -DSYSCALL_TRAP
+ *
+ * Each build prints one JSON line in the format of bench/sched_bench.cpp, so tools/bench_compare.py takes it too.
+ * The host figures only rank the two paths - the device cost is in the switch_profile figures (SWITCH_PROFILING).
+ */
+
+extern scheduler<scheduling_algorithms::lottery> os;
+
+void driver_init(void) { }
+
+using bench_clock = std::chrono::steady_clock;
+
+static const std::size_t num_yielders = 4;
+static const int passes = 3;
+
+static std::size_t target = 0;
+static std::size_t yields = 0;
+static int pass = 0;
+static std::uint64_t best = ~std::uint64_t(0);
+static bench_clock::time_point start;
+
+static std::int16_t yielder(void) {
+	for (;;) {
+		if (++yields == target) {
+			const auto stop = bench_clock::now();
+			best = std::min<std::uint64_t>(best, std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+
+			if (++pass == passes) {
+#ifdef SYSCALL_TRAP
+				const char *path = "trap";
+#else
+				const char *path = "watchdog";
+#endif
+				std::printf("{\"suite\": \"yield\", \"path\": \"%s\", \"tasks\": %zu, \"calls\": %zu, \"ns_per_call\": %.1f}\n",
+						path, num_yielders, target, static_cast<double>(best) / target);
+				std::exit(0);
+			}
+
+			yields = 0;
+			start = bench_clock::now();
+		}
+
+		os.suspend();
+	}
+}
+
+int main(int argc, char **argv) {
+	target = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+	// Only the yields switch - the tick would mix preemptions in
+	struct itimerval stop = { };
+	setitimer(ITIMER_REAL, &stop, nullptr);
+
+	for (std::size_t i = 0; i < num_yielders; ++i) os.add_task(yielder, 64, 1);
+
+	start = bench_clock::now();
+	os.start();
+}
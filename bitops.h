@@ -0,0 +1,40 @@
+/*
+ * bitops.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef BITOPS_H_
+#define BITOPS_H_
+
+#include <cstdint>
+
+/**
+ * Count leading zeros of a 16-bit word. The MSP430 has no CLZ instruction, so this resolves the answer a nibble
+ * at a time through a 16-entry table - constant time with at most two branches. clz16(0) is defined as 16.
+ */
+
+inline std::uint8_t clz16(std::uint16_t x) {
+	static const std::uint8_t nibble_clz[16] = {
+		4, 3, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0
+	};
+
+	if (x & 0xFF00) {
+		if (x & 0xF000) return nibble_clz[x >> 12];
+		return 4 + nibble_clz[x >> 8];
+	} else {
+		if (x & 0x00F0) return 8 + nibble_clz[x >> 4];
+		return 12 + nibble_clz[x & 0x000F];
+	}
+}
+
+/**
+ * Index of the most significant set bit of a nonzero 16-bit word
+ */
+
+inline std::uint8_t msb16(std::uint16_t x) {
+	return 15 - clz16(x);
+}
+
+#endif /* BITOPS_H_ */
@@ -13,3 +13,13 @@
  */
 
 scheduler<scheduling_algorithms::lottery> os;
+
+/**
+ * Every configured stack has to hold a preemption on top of the task's own frames
+ */
+
+static constexpr bool stacks_fit(std::size_t i) {
+	return i == sizeof(task_cfgs) / sizeof(struct task_config) || (task_cfgs[i].stack_size >= TASK_STACK_MIN && stacks_fit(i + 1));
+}
+
+static_assert(stacks_fit(0), "task_cfgs: a stack_size is below TASK_STACK_MIN - see config.h");
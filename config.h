@@ -14,7 +14,34 @@
 #include <cstddef>
 
 #define DEBUG_MODE
-#define INT_QUEUE_SIZE 32
+//#define STATIC_KERNEL		// Lay out tasks and stacks at compile time from task_cfgs - no heap use at boot
+//#define DEFERRED_LOGGING	// uart_log() sends format-string ids and raw arguments - decode with tools/log_decode.py. Frames are built in the TX ring, not on the caller's stack
+//#define SWITCH_PROFILING	// Timestamp every context switch on Timer_A1 - see switch_profile.h
+//#define PC_SAMPLING		// Sample the preempted PC on scheduler ticks - see pc_sample.h
+//#define CPU_ACCOUNTING	// Charge run time to tasks in Timer_A1 cycles - see cpu_time.h
+//#define TICKLESS_IDLE		// Stop the tick and sleep in LPM3 until the next sleeper is due - see tickless.h
+//#define SLICE_TIMER		// Preempt from Timer_A0 compares, honouring each task's quantum - see slice_timer.h
+//#define SYSCALL_TRAP		// Sleep, block, wait and yield call into the kernel instead of raising the watchdog interrupt
+#define MAX_IRQ_SOURCES 16		// Vectors that can have a handler attached (at most 16, one bit each in the pending mask)
+#define NUM_INTERRUPT_VECTORS 64	// Slots in the interrupt to handler table, indexed by the device's vector numbers
+#define NUM_PRIORITY_LEVELS 16	// Run lists in the round-robin ready queue (at most 16)
+#ifndef MAX_TASKS
+#define MAX_TASKS 32				// Tasks a scheduler accepts, interrupt handlers aside (at most 254)
+#endif
+
+/**
+ * Task stack sizes in words. A preemption stacks the task's registers and runs the first part of the context switch
+ * on the task's own stack, on top of whatever the task had in use - see "Task stacks" in README.md for the count.
+ * task_cfgs entries below TASK_STACK_MIN fail to compile, and add_task() raises smaller requests to it.
+ */
+
+#if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+#define TASK_STACK_MIN 80			// 52 words for a preemption under round robin, the rest for the task's own frames
+#define TASK_STACK_WORDS 192		// Default for the tasks below - enough for uart_log() under a preemption
+#else
+#define TASK_STACK_MIN 48			// 26 words for a preemption under round robin, the rest for the task's own frames
+#define TASK_STACK_WORDS 96			// Default for the tasks below - enough for uart_log() under a preemption
+#endif
 
 /**
  * Declare your functions here
@@ -40,6 +67,22 @@ struct task_config {
 	runnable func;
 	std::size_t stack_size;
 	std::uint8_t priority;
+
+	/**
+	 * Real-time parameters in ticks, used by the EDF scheduler - leave the period at 0 for a background task.
+	 * A deadline of 0 means the deadline equals the period.
+	 */
+
+	std::uint16_t period;
+	std::uint16_t wcet;
+	std::uint16_t deadline;
+
+	/**
+	 * Ticks per time slice, taken into account with SLICE_TIMER - leave at 0 for a single tick. Long slices suit
+	 * throughput tasks, short ones latency-sensitive tasks.
+	 */
+
+	std::uint8_t quantum;
 };
 
 /**
@@ -49,37 +92,37 @@ struct task_config {
 constexpr const struct task_config task_cfgs[] = {
 		{
 				.func = foo,
-				.stack_size = 32,
+				.stack_size = TASK_STACK_WORDS,
 				.priority = 1
 		},
 		{
 				.func = bar,
-				.stack_size = 32,
+				.stack_size = TASK_STACK_WORDS,
 				.priority = 2
 		},
 		{
 				.func = printer1,
-				.stack_size = 32,
+				.stack_size = TASK_STACK_WORDS,
 				.priority = 3,
 		},
 		{
 				.func = printer2,
-				.stack_size = 32,
+				.stack_size = TASK_STACK_WORDS,
 				.priority = 4,
 		},
 		{
 				.func = printer3,
-				.stack_size = 32,
+				.stack_size = TASK_STACK_WORDS,
 				.priority = 5,
 		},
 		{
 				.func = printer4,
-				.stack_size = 32,
+				.stack_size = TASK_STACK_WORDS,
 				.priority = 6,
 		},
 		{
 				.func = fib,
-				.stack_size = 32,
+				.stack_size = TASK_STACK_WORDS,
 				.priority = 7,
 
 		}
@@ -91,7 +134,9 @@ constexpr const struct task_config task_cfgs[] = {
 
 enum class scheduling_algorithms {
 	round_robin,
-	lottery
+	lottery,
+	stride,
+	edf
 };
 
 #endif /* CONFIG_H_ */
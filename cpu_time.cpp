@@ -0,0 +1,94 @@
+/*
+ * cpu_time.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <cpu_time.h>
+
+#ifdef CPU_ACCOUNTING
+
+enum cpu_class : std::uint8_t {
+	class_tasks,
+	class_handlers,
+	class_idle,
+	num_cpu_classes
+};
+
+static volatile std::uint16_t overflows = 0;	// Upper half of the clock, counted by the Timer_A1 overflow interrupt
+
+static std::uint32_t totals[num_cpu_classes];
+static std::uint32_t kernel_cycles = 0;
+
+static std::uint32_t dispatched_at = 0;		// When the running task was loaded
+static std::uint32_t switched_at = 0;		// When the last switch began
+static cpu_class running = class_tasks;
+static bool started = false;				// Nothing to charge before the first dispatch
+
+void cpu_time_init(void) {
+	TA1CTL = TASSEL_2 | ID_0 | MC_2 | TACLR | TAIE;	// SMCLK, undivided, continuous, interrupt on overflow
+}
+
+#if defined(HOST_PORT)
+std::uint32_t cpu_time_now(void) {
+	return host_timer_cycles();
+}
+#else
+std::uint32_t cpu_time_now(void) {
+	const std::uint16_t low = TA1R;
+	std::uint16_t high = overflows;
+
+	// Wrapped, but the interrupt has not been taken yet - a low count means the read came after the wrap
+	if ((TA1CTL & TAIFG) && low < 0x8000) ++high;
+
+	return (static_cast<std::uint32_t>(high) << 16) | low;
+}
+
+#pragma vector = TIMER1_A1_VECTOR
+__attribute__((interrupt)) void cpu_time_overflow(void) {
+	if (TA1IV == TA1IV_TAIFG) overflows++;	// Reading TA1IV clears the flag
+}
+#endif
+
+void cpu_time_switch_out(task &outgoing) {
+	switched_at = cpu_time_now();
+	if (!started) return;
+
+	const std::uint32_t used = switched_at - dispatched_at;
+	outgoing.charge(used);
+	totals[running] += used;
+}
+
+void cpu_time_switch_in(const task &incoming, bool handler) {
+	dispatched_at = cpu_time_now();
+	if (started) kernel_cycles += dispatched_at - switched_at;
+	started = true;
+
+	if (handler) running = class_handlers;
+	else if (&incoming == &task::idle_hook) running = class_idle;
+	else running = class_tasks;
+}
+
+std::uint32_t cpu_time_totals(cpu_snapshot &snap) {
+	snap.timestamp = cpu_time_now();
+	snap.tasks = totals[class_tasks];
+	snap.handlers = totals[class_handlers];
+	snap.idle = totals[class_idle];
+	snap.kernel = kernel_cycles;
+
+	if (!started) return 0;
+
+	// The slice in progress has not been charged yet
+	const std::uint32_t current = snap.timestamp - dispatched_at;
+	switch (running) {
+		case class_tasks: snap.tasks += current; break;
+		case class_handlers: snap.handlers += current; break;
+		case class_idle: snap.idle += current; break;
+		default: break;
+	}
+
+	return current;
+}
+
+#endif
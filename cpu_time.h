@@ -0,0 +1,81 @@
+/*
+ * cpu_time.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef CPU_TIME_H_
+#define CPU_TIME_H_
+
+#include <msp430.h>
+#include <config.h>
+#include <task.h>
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Per-task CPU time accounting. With CPU_ACCOUNTING defined, Timer_A1 runs free from SMCLK and its overflow
+ * interrupt extends it to 32 bits. Every context switch charges the cycles since the last dispatch to the outgoing
+ * task's thread_info::cycles, and the time spent inside the switch to the kernel. Time is also summed per class:
+ *
+ *     tasks      - ordinary tasks
+ *     handlers   - interrupt handler tasks (driver ISRs themselves are charged to whoever they interrupted)
+ *     idle       - task::idle_hook, low power mode included, since SMCLK keeps running in LPM0
+ *     kernel     - context_switch(), from the moment the outgoing task is saved to the jump into the next one
+ *
+ * abstract_scheduler::cpu_usage() takes a consistent snapshot of the totals and of every task's counter, with the
+ * slice in progress included. The counters wrap (after about 170 s at 25 MHz), so utilization is the difference of
+ * two snapshots over the difference of their timestamps - cpu_permille() does the division.
+ *
+ * Timer_A1 is shared with the context switch profiler, which only ever takes 16-bit differences of it.
+ */
+
+struct cpu_snapshot {
+	std::uint32_t timestamp;	// Timer_A1 cycles at the time of the snapshot
+	std::uint32_t tasks;
+	std::uint32_t handlers;
+	std::uint32_t idle;
+	std::uint32_t kernel;
+	std::size_t count;			// Entries written to the task table
+};
+
+struct task_usage {
+	std::uint16_t id;
+	std::uint8_t priority;
+	std::uint32_t cycles;
+};
+
+// Starts the free-running timer - the accounting starts with the first dispatch
+void cpu_time_init(void);
+
+// Timer_A1 extended to 32 bits - interrupts must be disabled
+std::uint32_t cpu_time_now(void);
+
+// Charges the slice that just ended to the outgoing task - called from context_switch() once it is saved
+void cpu_time_switch_out(task &outgoing);
+
+// Starts the slice of the task about to be loaded
+void cpu_time_switch_in(const task &incoming, bool handler);
+
+// Fills in the timestamp and class totals, and returns the cycles the running task has used so far this slice
+std::uint32_t cpu_time_totals(cpu_snapshot &snap);
+
+/**
+ * Share of a window spent on something, in tenths of a percent
+ */
+
+inline std::uint16_t cpu_permille(std::uint32_t part, std::uint32_t window) {
+	// Scale both down until part * 1000 fits in 32 bits - no 64-bit division on the MSP430
+	while (window > 0x3FFFFFul) {
+		window >>= 1;
+		part >>= 1;
+	}
+
+	if (window == 0) return 0;
+	if (part > window) part = window;
+	return static_cast<std::uint16_t>((part * 1000) / window);
+}
+
+#endif /* CPU_TIME_H_ */
@@ -138,6 +138,171 @@ end:      BR      R14
 
           .endasmfunc
 
+;****************************************************************************
+;*   ctx_trap
+;*
+;*     C syntax  : void ctx_trap(ctx env, void *kstack, void (*kernel)(void))
+;*
+;*     Function  : System call entry. Saves the caller's environment like
+;*                 ctx_save - the callee-saved registers, SP and the
+;*                 return address, nothing the compiler expects to survive
+;*                 a call beyond that - then switches to the kernel stack
+;*                 and calls the kernel, which never returns. A later
+;*                 ctx_load on env returns from ctx_trap to the caller.
+;****************************************************************************
+	.global	ctx_trap
+
+	.if $DEFINED(__LARGE_CODE_MODEL__) | $DEFINED(__LARGE_DATA_MODEL__)
+ctx_trap: .asmfunc stack_usage(RETADDRSZ)
+          MOVA   R4, 0(R12)			; save R4
+          MOVA   R5, 4(R12)			; save R5
+          MOVA   R6, 8(R12)			; save R6
+          MOVA   R7, 12(R12)		; save R7
+          MOVA   R8, 16(R12)		; save R8
+          MOVA   R9, 20(R12)		; save R9
+          MOVA   R10, 24(R12)		; save R10
+          MOVA   SP, 28(R12)		; save SP
+
+	.if $DEFINED(__LARGE_CODE_MODEL__)
+          MOVX.A @SP,32(R12)		; return address is the resume PC
+          ADDX.A #4,28(R12)        	; Increment saved SP by four ("pop" PC)
+          MOVA   R13, SP			; onto the kernel stack
+          CALLA  R14				; enter the kernel - no return
+	.else
+		  MOV.W  @SP,32(R12)
+		  ADDX.A #2,28(R12)
+          MOVA   R13, SP
+          CALL   R14
+	.endif
+	.else
+ctx_trap: .asmfunc stack_usage(RETADDRSZ)
+          MOV.W   R4,0(R12)
+          MOV.W   R5,2(R12)
+          MOV.W   R6,4(R12)
+          MOV.W   R7,6(R12)
+          MOV.W   R8,8(R12)
+          MOV.W   R9,10(R12)
+          MOV.W   R10,12(R12)
+          MOV.W   SP,14(R12)
+          MOV.W   @SP,16(R12)		; return address is the resume PC
+          ADD.W   #2,14(R12)        ; Increment saved SP by two ("pop" PC)
+          MOV.W   R13,SP			; onto the kernel stack
+          CALL    R14				; enter the kernel - no return
+	.endif
+
+          .endasmfunc
+
+;****************************************************************************
+;*   ctx_preempt
+;*
+;*     C syntax  : none - branched to from the naked preempt() ISR
+;*
+;*     Function  : Saves the complete register frame of a preempted task
+;*                 on the task's own stack. The interrupt has pushed PC
+;*                 and SR already; R15 down to R4 go below them, with
+;*                 PUSHM.A on CPUX builds using the large code or data
+;*                 model, where all 20 bits count. The frame's address is
+;*                 handed to preempt_switch, which never returns.
+;*
+;*     The frame, from the saved SP up:
+;*
+;*       frame -->  R4 ... R15		4 bytes each with PUSHM.A, else 2
+;*                  SR				PC[19:16] in bits 15:12 on CPUX
+;*                  PC[15:0]
+;*
+;*   ctx_frame_return
+;*
+;*     Function  : Resume point of a preempted task, reached through
+;*                 ctx_load with SP at the frame. Pops the registers and
+;*                 returns from the interrupt, which restores SR and PC.
+;*
+;*   ctx_frame_resume
+;*
+;*     C syntax  : void ctx_frame_resume(void *frame)
+;*
+;*     Function  : Hands a preempted task its next slice in place, when
+;*                 the scheduler picked it again before leaving its stack.
+;*                 Nothing was loaded, so SP goes straight back to the
+;*                 frame and the tick is re-armed. Interrupts stay off
+;*                 until RETI restores the task's SR.
+;****************************************************************************
+	.global preempt_switch
+	.global	ctx_preempt
+	.global	ctx_frame_return
+	.global	ctx_frame_resume
+
+	.if $DEFINED(__LARGE_CODE_MODEL__) | $DEFINED(__LARGE_DATA_MODEL__)
+ctx_preempt: .asmfunc stack_usage(RETADDRSZ + 48)	; R4-R15 at 4 bytes, then the call
+          PUSHM.A #12, R15			; save R15 down to R4
+          MOVA   SP, R12			; the frame is the argument
+
+	.if $DEFINED(__LARGE_CODE_MODEL__)
+          CALLA  #preempt_switch	; enter the kernel - no return
+	.else
+          CALL   #preempt_switch
+	.endif
+
+          .endasmfunc
+
+ctx_frame_return: .asmfunc
+          POPM.A #12, R15			; load R4 up to R15
+          RETI						; load SR and PC
+          .endasmfunc
+
+ctx_frame_resume: .asmfunc stack_usage(RETADDRSZ)
+          MOVA   R12, SP			; back onto the frame
+
+	.if $DEFINED(__LARGE_CODE_MODEL__)
+          CALLA  #wdt_reload		; reset the watchdog timer for a new time slice
+          BRA    #ctx_frame_return
+	.else
+          CALL   #wdt_reload
+          BR     #ctx_frame_return
+	.endif
+
+          .endasmfunc
+
+	.else
+ctx_preempt: .asmfunc stack_usage(RETADDRSZ + 24)	; R4-R15 at 2 bytes, then the call
+          PUSH.W  R15				; no PUSHM on the original CPU
+          PUSH.W  R14
+          PUSH.W  R13
+          PUSH.W  R12
+          PUSH.W  R11
+          PUSH.W  R10
+          PUSH.W  R9
+          PUSH.W  R8
+          PUSH.W  R7
+          PUSH.W  R6
+          PUSH.W  R5
+          PUSH.W  R4
+          MOV.W   SP, R12
+          CALL    #preempt_switch
+          .endasmfunc
+
+ctx_frame_return: .asmfunc
+          POP.W   R4
+          POP.W   R5
+          POP.W   R6
+          POP.W   R7
+          POP.W   R8
+          POP.W   R9
+          POP.W   R10
+          POP.W   R11
+          POP.W   R12
+          POP.W   R13
+          POP.W   R14
+          POP.W   R15
+          RETI
+          .endasmfunc
+
+ctx_frame_resume: .asmfunc stack_usage(RETADDRSZ)
+          MOV.W   R12, SP
+          CALL    #wdt_reload
+          BR      #ctx_frame_return
+          .endasmfunc
+	.endif
+
 ;******************************************************************************
 ;* BUILD ATTRIBUTES                                                           *
 ;*    HW_MPY_INLINE_INFO=1:  file does not have any inlined hw mpy            *
@@ -0,0 +1,199 @@
+/*
+ * deferred_log.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef DEFERRED_LOG_H_
+#define DEFERRED_LOG_H_
+
+#include <config.h>
+#include <print.h>
+#include <format.h>
+
+#include <cstdint>
+#include <cstddef>
+
+#include <type_traits>
+
+/**
+ * Deferred (tokenized) logging. With DEFERRED_LOGGING defined, uart_log() does no formatting on the device: the
+ * format string is parked in the .log_strings section, which is kept in the ELF but never loaded, and the call
+ * site only sends a frame holding the string's address and the raw argument bytes:
+ *
+ *     [0xA5] [id lo] [id hi] [payload length] [payload ...]
+ *
+ * tools/log_decode.py looks the id up in the ELF and does the formatting on the host. Plain text sent through
+ * uart_printf() is 7-bit ASCII, so the decoder can tell the two apart on the same line.
+ *
+ * Arguments are encoded by their C++ type and decoded by the format specifier, so the two are checked against each
+ * other at compile time: %c takes a char (1 byte), %i / %u / %x a short or an int (2 bytes), %l / %n a long
+ * (4 bytes) and %s a string (length byte followed by the characters, cut short if the frame fills up). std::size_t
+ * is an unsigned long in the large data model and on the host, so it has to go through %n there.
+ *
+ * Without DEFERRED_LOGGING, uart_log() formats on the device through uart_format().
+ */
+
+namespace deferred_log {
+
+constexpr std::uint8_t frame_sync = 0xA5;
+constexpr std::size_t frame_header = 4;
+constexpr std::size_t frame_size = 32;	// Largest frame, header included - at most half the TX ring, see uart_reserve()
+
+/**
+ * Byte sinks for a frame's payload. Both stop at frame_size, so measuring a frame and then writing it out always
+ * comes to the same length.
+ */
+
+class frame_measure {
+public:
+	frame_measure() : room(frame_size - frame_header) { }
+
+	inline std::size_t left(void) const { return this->room; }
+	inline std::size_t length(void) const { return frame_size - frame_header - this->room; }
+	inline void put(std::uint8_t) { --this->room; }
+
+protected:
+	std::size_t room;
+};
+
+class frame_writer : public frame_measure {
+public:
+	explicit frame_writer(const ring_region<char> &region) : region(region), at(0) { }
+
+	inline void put(std::uint8_t b) {
+		if (this->at < this->region.first.size) this->region.first.data[this->at] = static_cast<char>(b);
+		else this->region.second.data[this->at - this->region.first.size] = static_cast<char>(b);
+
+		++this->at;
+	}
+
+	inline void put_payload(std::uint8_t b) {
+		this->put(b);
+		--this->room;
+	}
+
+private:
+	const ring_region<char> &region;
+	std::size_t at;
+};
+
+inline void put_byte(frame_measure &out, std::uint8_t b) { out.put(b); }
+inline void put_byte(frame_writer &out, std::uint8_t b) { out.put_payload(b); }
+
+template <class Sink>
+inline void put_bytes(Sink &out, std::uint32_t v, std::size_t n) {
+	for (std::size_t i = 0; i < n && out.left() > 0; ++i, v >>= 8) put_byte(out, static_cast<std::uint8_t>(v));
+}
+
+template <class Sink> inline void put_arg(Sink &out, char v) { put_bytes(out, v, 1); }
+template <class Sink> inline void put_arg(Sink &out, signed char v) { put_bytes(out, v, 1); }
+template <class Sink> inline void put_arg(Sink &out, unsigned char v) { put_bytes(out, v, 1); }
+template <class Sink> inline void put_arg(Sink &out, short v) { put_bytes(out, v, 2); }
+template <class Sink> inline void put_arg(Sink &out, unsigned short v) { put_bytes(out, v, 2); }
+template <class Sink> inline void put_arg(Sink &out, int v) { put_bytes(out, v, 2); }
+template <class Sink> inline void put_arg(Sink &out, unsigned int v) { put_bytes(out, v, 2); }
+template <class Sink> inline void put_arg(Sink &out, long v) { put_bytes(out, v, 4); }
+template <class Sink> inline void put_arg(Sink &out, unsigned long v) { put_bytes(out, v, 4); }
+
+template <class Sink>
+inline void put_arg(Sink &out, const char *s) {
+	if (out.left() == 0) return;
+
+	std::size_t n = 0;
+	while (s[n] != '\0' && n < out.left() - 1) ++n;
+
+	put_byte(out, static_cast<std::uint8_t>(n));
+	for (std::size_t i = 0; i < n; ++i) put_byte(out, static_cast<std::uint8_t>(s[i]));
+}
+
+/**
+ * Bytes put_arg() encodes an argument in, and bytes the decoder takes for a conversion - 0 for strings
+ */
+
+constexpr std::size_t no_width = ~std::size_t(0);
+
+template <class T>
+constexpr std::size_t encoded_width(void) {
+	return (std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value) ? 1 :
+		(std::is_same<T, short>::value || std::is_same<T, unsigned short>::value) ? 2 :
+		(std::is_same<T, int>::value || std::is_same<T, unsigned int>::value) ? 2 :
+		(std::is_same<T, long>::value || std::is_same<T, unsigned long>::value) ? 4 :
+		(std::is_same<T, const char *>::value || std::is_same<T, char *>::value) ? 0 :
+		no_width;
+}
+
+constexpr std::size_t decoded_width(char c) {
+	return (c == 'c') ? 1 :
+		(c == 'i' || c == 'u' || c == 'x') ? 2 :
+		(c == 'l' || c == 'n') ? 4 :
+		(c == 's') ? 0 :
+		no_width;
+}
+
+template <class F, std::size_t N>
+constexpr bool all_encodable(void) {
+	return true;
+}
+
+template <class F, std::size_t N, class T, class... Rest>
+constexpr bool all_encodable(void) {
+	return encoded_width<T>() == decoded_width(format_detail::spec<F, N>()) && all_encodable<F, N + 1, Rest...>();
+}
+
+template <class Sink>
+inline void put_args(Sink &) { }
+
+template <class Sink, class Arg, class... Args>
+inline void put_args(Sink &out, Arg arg, Args... args) {
+	put_arg(out, arg);
+	put_args(out, args...);
+}
+
+/**
+ * Measures the frame, then writes it straight into the TX ring - there is no copy of it on the caller's stack,
+ * which matters on task stacks that already hold a preemption frame. The whole frame is reserved at once, so the
+ * RX echo or another writer cannot land in the middle of it.
+ */
+
+template <class Format, class... Args>
+void send(Format, const char *format, Args... args) {
+	static_assert(format_detail::valid(Format::get()), "uart_log: unknown conversion in the format string");
+	static_assert(format_detail::count(Format::get()) == sizeof...(Args), "uart_log: argument count does not match the format string");
+	static_assert(all_encodable<Format, 0, Args...>(), "uart_log: argument width does not match its conversion - see deferred_log.h");
+
+	frame_measure measure;
+	put_args(measure, args...);
+
+	const std::size_t length = measure.length();
+	const std::uint16_t id = static_cast<std::uint16_t>(reinterpret_cast<std::uintptr_t>(format));
+
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	const ring_region<char> region = uart_reserve(frame_header + length);
+	frame_writer out(region);
+
+	out.put(frame_sync);
+	out.put(static_cast<std::uint8_t>(id));
+	out.put(static_cast<std::uint8_t>(id >> 8));
+	out.put(static_cast<std::uint8_t>(length));
+	put_args(out, args...);
+
+	uart_commit(frame_header + length);
+	_set_interrupt_state(state);
+}
+
+}
+
+#ifdef DEFERRED_LOGGING
+#define uart_log(format, ...) do { \
+	static const char log_format_[] __attribute__((section(".log_strings"), used)) = format; \
+	deferred_log::send(format_string(format), log_format_, ##__VA_ARGS__); \
+} while (0)
+#else
+#define uart_log(format, ...) uart_format(format_string(format), ##__VA_ARGS__)
+#endif
+
+#endif /* DEFERRED_LOG_H_ */
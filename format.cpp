@@ -0,0 +1,125 @@
+/*
+ * format.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <format.h>
+
+/**
+ * Writes into a caller buffer, dropping what does not fit
+ */
+
+format_sink::format_sink(char *buf, std::size_t size) : base(buf), cur(buf), end(buf + size), next(nullptr),
+	next_size(0), flush(nullptr), count(0) { }
+
+/**
+ * Writes into a region reserved on a ring buffer - commit size() slots once done
+ */
+
+format_sink::format_sink(const ring_region<char> &region) : base(region.first.data), cur(region.first.data),
+	end(region.first.data + region.first.size), next(region.second.data), next_size(region.second.size),
+	flush(nullptr), count(0) { }
+
+/**
+ * Stages output in a small buffer and hands it to flush every time the buffer fills up
+ */
+
+format_sink::format_sink(char *buf, std::size_t size, flush_fn flush) : base(buf), cur(buf), end(buf + size),
+	next(nullptr), next_size(0), flush(flush), count(0) { }
+
+/**
+ * Slow path of put() - drain the staging buffer, move to the second span, or drop the character
+ */
+
+void format_sink::overflow(char c) {
+	if (this->flush != nullptr) {
+		this->flush(this->base, this->cur - this->base);
+		this->cur = this->base;
+	} else if (this->next != nullptr) {
+		this->cur = this->next;
+		this->end = this->next + this->next_size;
+		this->next = nullptr;
+	}
+
+	if (this->cur != this->end) {
+		*this->cur++ = c;
+		++this->count;
+	}
+}
+
+void format_sink::write(const char *s, std::size_t n) {
+	while (n-- > 0) this->put(*s++);
+}
+
+void format_sink::puts(const char *s) {
+	while (*s != '\0') this->put(*s++);
+}
+
+void format_sink::finish(void) {
+	if (this->flush != nullptr && this->cur != this->base) {
+		this->flush(this->base, this->cur - this->base);
+		this->cur = this->base;
+	}
+}
+
+/**
+ * Powers of ten for the subtraction loops
+ */
+
+static const std::uint16_t dec16[] = { 10000, 1000, 100, 10, 1 };
+
+static const std::uint32_t dec32[] = {
+	1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1
+};
+
+void format_udec(format_sink &out, std::uint16_t x) {
+	if (x == 0) {
+		out.put('0');
+		return;
+	}
+
+	const std::uint16_t *dp = dec16;
+	while (x < *dp) ++dp;	// Skip leading zeros
+
+	do {
+		const std::uint16_t d = *dp++;
+		char c = '0';
+		while (x >= d) {
+			++c;
+			x -= d;
+		}
+
+		out.put(c);
+	} while (dp != dec16 + sizeof(dec16) / sizeof(dec16[0]));
+}
+
+void format_udec(format_sink &out, std::uint32_t x) {
+	if (x <= 0xFFFF) {	// Stay on single words where the value allows it
+		format_udec(out, static_cast<std::uint16_t>(x));
+		return;
+	}
+
+	const std::uint32_t *dp = dec32;
+	while (x < *dp) ++dp;
+
+	do {
+		const std::uint32_t d = *dp++;
+		char c = '0';
+		while (x >= d) {
+			++c;
+			x -= d;
+		}
+
+		out.put(c);
+	} while (dp != dec32 + sizeof(dec32) / sizeof(dec32[0]));
+}
+
+void format_hex(format_sink &out, std::uint32_t x, std::uint8_t digits) {
+	static const char hex[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+
+	while (digits-- > 0) {
+		out.put(hex[(x >> (digits << 2)) & 0xF]);
+	}
+}
@@ -0,0 +1,260 @@
+/*
+ * format.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+#include <ring_buffer.h>
+
+#include <cstdint>
+#include <cstddef>
+
+#include <type_traits>
+#include <utility>
+
+/**
+ * Destination of the formatter - a caller buffer, a ring_buffer reservation (two spans) or a small staging buffer
+ * that is drained through a flush callback whenever it fills up. Nothing here ever allocates; output that does not
+ * fit a buffer or region is dropped and size() stops counting.
+ */
+
+class format_sink {
+public:
+	using flush_fn = void (*)(const char *, std::size_t);
+
+	format_sink(char *buf, std::size_t size);
+	format_sink(const ring_region<char> &region);
+	format_sink(char *buf, std::size_t size, flush_fn flush);
+
+	inline void put(char c);
+	void write(const char *s, std::size_t n);
+	void puts(const char *s);
+
+	// Drains whatever is still staged through the flush callback
+	void finish(void);
+
+	// Characters written so far
+	inline std::size_t size(void) const;
+
+private:
+	void overflow(char c);
+
+	char *base;
+	char *cur;
+	char *end;
+	char *next;				// Second span of a ring region, nullptr once in use
+	std::size_t next_size;
+	flush_fn flush;
+	std::size_t count;
+};
+
+inline void format_sink::put(char c) {
+	if (this->cur != this->end) {
+		*this->cur++ = c;
+		++this->count;
+	} else {
+		this->overflow(c);
+	}
+}
+
+inline std::size_t format_sink::size(void) const {
+	return this->count;
+}
+
+/**
+ * Digit emitters shared by every printer. The MSP430 has no divider, so decimals come out by repeated subtraction
+ * of powers of ten, on 16-bit words whenever the value allows it.
+ */
+
+void format_udec(format_sink &out, std::uint16_t x);
+void format_udec(format_sink &out, std::uint32_t x);
+void format_hex(format_sink &out, std::uint32_t x, std::uint8_t digits);
+
+/**
+ * Compile-time format strings. format_string("...") turns a literal into a type, and format_to() parses it while
+ * compiling: the literal runs between conversions and the conversion of every argument are fixed at that point,
+ * so a call only copies runs and converts numbers. The conversions are those of uart_printf() - %c, %s, %i / %u /
+ * %x (int), %l / %n (long) - and argument count and types are checked by static_assert.
+ *
+ *     format_to(out, format_string("foo: %u\r\n"), ticks);
+ */
+
+#define format_string(str) ([] { \
+	struct format_literal { static constexpr const char *get(void) { return str; } }; \
+	return format_literal(); \
+}())
+
+namespace format_detail {
+
+constexpr std::size_t length(const char *s) {
+	std::size_t n = 0;
+	while (s[n] != '\0') ++n;
+	return n;
+}
+
+// Whether every '%' is followed by a known conversion
+constexpr bool valid(const char *s) {
+	for (std::size_t p = 0; s[p] != '\0'; ++p) {
+		if (s[p] != '%') continue;
+
+		switch (s[++p]) {
+			case 'c': case 's': case 'i': case 'u': case 'x': case 'l': case 'n': break;
+			default: return false;
+		}
+	}
+
+	return true;
+}
+
+constexpr std::size_t count(const char *s) {
+	std::size_t n = 0;
+	for (std::size_t p = 0; s[p] != '\0'; ++p) {
+		if (s[p] == '%' && s[p + 1] != '\0') ++n, ++p;
+	}
+
+	return n;
+}
+
+// Position of the n-th conversion, the end of the string if there are fewer
+constexpr std::size_t conversion_at(const char *s, std::size_t n) {
+	for (std::size_t p = 0; s[p] != '\0'; ++p) {
+		if (s[p] != '%') continue;
+		if (n-- == 0) return p;
+		if (s[p + 1] != '\0') ++p;
+	}
+
+	return length(s);
+}
+
+// Start of the literal run in front of the n-th conversion
+constexpr std::size_t run_at(const char *s, std::size_t n) {
+	return (n == 0) ? 0 : conversion_at(s, n - 1) + 2;
+}
+
+template <class F, std::size_t N>
+constexpr char spec(void) {
+	return (conversion_at(F::get(), N) < length(F::get())) ? F::get()[conversion_at(F::get(), N) + 1] : '\0';
+}
+
+template <class T>
+constexpr bool integer(void) {
+	return std::is_integral<T>::value && !std::is_same<T, bool>::value;
+}
+
+template <class T>
+constexpr bool accepts(char c) {
+	return (c == 'c') ? (std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value) :
+		(c == 's') ? (std::is_same<T, const char *>::value || std::is_same<T, char *>::value) :
+		(c == 'i' || c == 'u' || c == 'x') ? (integer<T>() && (sizeof(T) <= sizeof(int) || std::is_same<T, std::size_t>::value)) :
+		(c == 'l' || c == 'n') ? (integer<T>() && sizeof(T) <= sizeof(long)) :
+		false;
+}
+
+template <class F, std::size_t N>
+constexpr bool all_accepted(void) {
+	return true;
+}
+
+template <class F, std::size_t N, class T, class... Rest>
+constexpr bool all_accepted(void) {
+	return accepts<T>(spec<F, N>()) && all_accepted<F, N + 1, Rest...>();
+}
+
+/**
+ * One conversion, chosen at compile time
+ */
+
+template <class T>
+inline void put_unsigned(format_sink &out, T x) {
+	if (sizeof(T) <= sizeof(std::uint16_t)) format_udec(out, static_cast<std::uint16_t>(x));
+	else format_udec(out, static_cast<std::uint32_t>(x));
+}
+
+template <class T>
+inline void put_signed(format_sink &out, T x) {
+	using U = typename std::make_unsigned<T>::type;
+
+	if (x < 0) {
+		out.put('-');
+		put_unsigned(out, static_cast<U>(0u - static_cast<U>(x)));
+	} else {
+		put_unsigned(out, static_cast<U>(x));
+	}
+}
+
+template <char C>
+struct conversion;
+
+template <>
+struct conversion<'c'> {
+	template <class T>
+	static void put(format_sink &out, T x) { out.put(static_cast<char>(x)); }
+};
+
+template <>
+struct conversion<'s'> {
+	static void put(format_sink &out, const char *s) { out.puts(s); }
+};
+
+template <>
+struct conversion<'u'> {
+	template <class T>
+	static void put(format_sink &out, T x) { put_unsigned(out, static_cast<typename std::make_unsigned<T>::type>(x)); }
+};
+
+template <>
+struct conversion<'n'> : conversion<'u'> { };
+
+template <>
+struct conversion<'i'> {
+	template <class T>
+	static void put(format_sink &out, T x) { put_signed(out, static_cast<typename std::make_signed<T>::type>(x)); }
+};
+
+template <>
+struct conversion<'l'> : conversion<'i'> { };
+
+template <>
+struct conversion<'x'> {
+	template <class T>
+	static void put(format_sink &out, T x) {
+		format_hex(out, static_cast<std::uint32_t>(x), (sizeof(T) <= sizeof(std::uint16_t)) ? 4 : 8);
+	}
+};
+
+template <class F, std::size_t N>
+inline void put_run(format_sink &out) {
+	constexpr std::size_t start = run_at(F::get(), N);
+	constexpr std::size_t stop = conversion_at(F::get(), N);
+	out.write(F::get() + start, stop - start);
+}
+
+template <class F, class... Args, std::size_t... I>
+inline void emit(format_sink &out, std::index_sequence<I...>, const Args &... args) {
+	int expand[] = { 0, (put_run<F, I>(out), conversion<spec<F, I>()>::put(out, args), 0)... };
+	(void) expand;
+
+	put_run<F, sizeof...(I)>(out);	// Literal tail after the last conversion
+}
+
+}
+
+/**
+ * Formats the arguments into a sink and returns the number of characters written so far
+ */
+
+template <class Format, class... Args>
+std::size_t format_to(format_sink &out, Format, const Args &... args) {
+	static_assert(format_detail::valid(Format::get()), "format_to: unknown conversion in the format string");
+	static_assert(format_detail::count(Format::get()) == sizeof...(Args), "format_to: argument count does not match the format string");
+	static_assert(format_detail::all_accepted<Format, 0, typename std::decay<Args>::type...>(), "format_to: argument type does not match its conversion");
+
+	format_detail::emit<Format>(out, std::index_sequence_for<Args...>(), args...);
+	return out.size();
+}
+
+#endif /* FORMAT_H_ */
@@ -18,6 +18,7 @@ extern scheduler<scheduling_algorithms::lottery> os;
  */
 
 #include <print.h>
+#include <deferred_log.h>
 
 /**
  * Fill out your function bodies here
@@ -30,7 +31,7 @@ std::int16_t foo(void) {
 	while (1) {
 		P1OUT ^= BIT0;
 		_disable_interrupt();
-		uart_printf("foo: %u\r\n", os.get_thread_state().ticks);
+		uart_log("foo: %n\r\n", static_cast<unsigned long>(os.get_thread_state().ticks));
 		_enable_interrupt();
 //		os.sleep(4);
 	}
@@ -43,7 +44,7 @@ std::int16_t bar(void) {
 	while (1) {
 		P4OUT ^= BIT7;
 		_disable_interrupt();
-		uart_printf("bar: %u\r\n", os.get_thread_state().ticks);
+		uart_log("bar: %n\r\n", static_cast<unsigned long>(os.get_thread_state().ticks));
 		_enable_interrupt();
 //		os.sleep(8);
 	}
@@ -55,7 +56,7 @@ std::int16_t printer1(void) {
 	while (1) {
 		P1OUT ^= BIT1;
 		_disable_interrupt();
-		uart_printf("printer1: %u\r\n", os.get_thread_state().ticks);
+		uart_log("printer1: %n\r\n", static_cast<unsigned long>(os.get_thread_state().ticks));
 		_enable_interrupt();
 //		os.sleep(12);
 	}
@@ -64,7 +65,7 @@ std::int16_t printer1(void) {
 std::int16_t printer2(void) {
 	while (1) {
 		_disable_interrupt();
-		uart_printf("printer2: %u\r\n", os.get_thread_state().ticks);
+		uart_log("printer2: %n\r\n", static_cast<unsigned long>(os.get_thread_state().ticks));
 		_enable_interrupt();
 //		os.sleep(16);
 	}
@@ -73,7 +74,7 @@ std::int16_t printer2(void) {
 std::int16_t printer3(void) {
 	while (1) {
 		_disable_interrupt();
-		uart_printf("printer3: %u\r\n", os.get_thread_state().ticks);
+		uart_log("printer3: %n\r\n", static_cast<unsigned long>(os.get_thread_state().ticks));
 		_enable_interrupt();
 //		os.sleep(12);
 	}
@@ -82,7 +83,7 @@ std::int16_t printer3(void) {
 std::int16_t printer4(void) {
 	while (1) {
 		_disable_interrupt();
-		uart_printf("printer4: %u\r\n", os.get_thread_state().ticks);
+		uart_log("printer4: %n\r\n", static_cast<unsigned long>(os.get_thread_state().ticks));
 		_enable_interrupt();
 //		os.sleep(8);
 	}
@@ -91,7 +92,7 @@ std::int16_t printer4(void) {
 std::int16_t fib(void) {
 	while (1) {
 		_disable_interrupt();
-		uart_printf("fib: %u\r\n", os.get_thread_state().ticks);
+		uart_log("fib: %n\r\n", static_cast<unsigned long>(os.get_thread_state().ticks));
 		_enable_interrupt();
 //		os.sleep(4);
 	}
@@ -7,9 +7,8 @@
 
 #include <handler.h>
 
-handler::handler(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t latency) {
-	new (this) task::task(runnable, stack_size, latency, true);
-}
+handler::handler(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t latency)
+	: task(runnable, stack_size, latency, true), latency(latency) { }
 
 bool handler::ready(void) {
 	if (this->latency == 0) {
@@ -90,9 +90,12 @@ SECTIONS
     .bss        : {} > RAM                  /* Global & static vars              */
     .data       : {} > RAM                  /* Global & static vars              */
     .TI.noinit  : {} > RAM                  /* For #pragma noinit                */
+    .task_stacks : {} > RAM                 /* Statically allocated task stacks  */
     .sysmem     : {} > RAM                  /* Dynamic memory allocation area    */
     .stack      : {} > RAM (HIGH)           /* Software system stack             */
 
+    .log_strings : {} > FLASH, type = COPY  /* Deferred-log format strings, never loaded */
+
     .text       : {} > FLASH                /* Code                              */
     .cinit      : {} > FLASH                /* Initialization tables             */
     .const      : {} > FLASH                /* Constant data                     */
@@ -17,7 +17,12 @@ void driver_init(void) {
 int main(void) {
 	WDTCTL = WDTPW | WDTHOLD;	// stop watchdog timer
 
-	os.init();
+	if (!os.init()) {	// The task set failed admission or holds more than MAX_TASKS tasks - run none of it
+		P1DIR |= BIT0;
+		P1OUT |= BIT0;
+		for (;;) _low_power_mode_4();
+	}
+
 	os.start();
 	return 0;
 }
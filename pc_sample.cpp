@@ -0,0 +1,68 @@
+/*
+ * pc_sample.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <pc_sample.h>
+#include <ring_buffer.h>
+#include <print.h>
+
+#include <initializer_list>
+
+#ifdef PC_SAMPLING
+
+volatile bool pc_sample_skip = false;
+
+static pc_sample sample_storage[PC_SAMPLE_BUFFER];
+static ring_buffer<pc_sample, overflow_policy::drop_new> samples(sample_storage, PC_SAMPLE_BUFFER);	// Filled by the tick, drained by a task
+
+static std::uint16_t ticks_to_sample = PC_SAMPLE_INTERVAL;
+static std::uint32_t dropped = 0;
+
+/**
+ * Called from context_switch() with interrupts disabled, once the preempted task's context is saved
+ */
+
+void pc_sample_take(const task &preempted) {
+	if (pc_sample_skip) {
+		pc_sample_skip = false;
+		return;
+	}
+
+	if (--ticks_to_sample > 0) return;
+	ticks_to_sample = PC_SAMPLE_INTERVAL;
+
+	if (!samples.put({ preempted.get_resume_pc(), preempted.get_tid() })) dropped++;
+}
+
+/**
+ * Prints and releases what the ring held when the dump started - samples taken meanwhile wait for the next one
+ */
+
+void pc_sample_dump(void) {
+	const ring_region<const pc_sample> held = samples.peek(samples.size());
+
+	for (const ring_span<const pc_sample> &run : { held.first, held.second }) {
+		for (const pc_sample &s : run) {
+			uart_format(format_string("pc %u %n\r\n"), s.tid, static_cast<std::uint32_t>(s.pc));
+		}
+	}
+
+	samples.release(held.size());
+
+	const std::uint32_t lost = pc_sample_dropped();
+	if (lost != 0) uart_format(format_string("pc dropped %n\r\n"), lost);
+}
+
+std::uint32_t pc_sample_dropped(void) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+	const std::uint32_t count = dropped;
+	_set_interrupt_state(state);
+
+	return count;
+}
+
+#endif
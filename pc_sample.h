@@ -0,0 +1,72 @@
+/*
+ * pc_sample.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef PC_SAMPLE_H_
+#define PC_SAMPLE_H_
+
+#include <config.h>
+#include <task.h>
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Statistical PC-sampling profiler. With PC_SAMPLING defined, every PC_SAMPLE_INTERVAL-th scheduler tick records
+ * the address the preempted task was interrupted at, together with its task id, into a ring of PC_SAMPLE_BUFFER
+ * samples. Only ticks are sampled - switches the kernel asked for itself (sleep, wait, yield, driver wake-ups) land
+ * on the same few kernel call sites and would skew the profile.
+ *
+ * A task drains the ring with pc_sample_dump(), which prints one line per sample:
+ *
+ *     pc <tid> <address>
+ *
+ * and tools/pc_symbolize.py maps the addresses to functions from the firmware ELF, giving a per-task, per-function
+ * share of the CPU. Samples taken while the ring is full are dropped and counted, so a profile never stalls the
+ * tick. Without PC_SAMPLING the hooks compile to nothing and the rest is left out of the build.
+ */
+
+#ifndef PC_SAMPLE_INTERVAL
+#define PC_SAMPLE_INTERVAL 1	// Ticks per sample
+#endif
+
+#ifndef PC_SAMPLE_BUFFER
+#define PC_SAMPLE_BUFFER 64		// Samples held until the next dump (rounded down to a power of two)
+#endif
+
+struct pc_sample {
+#if defined(HOST_PORT)
+	std::uintptr_t pc;
+#elif defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+	std::uint32_t pc;
+#else
+	std::uint16_t pc;
+#endif
+	std::uint16_t tid;
+};
+
+extern volatile bool pc_sample_skip;
+
+// Takes a sample of the task that was just preempted, if this tick is due one
+void pc_sample_take(const task &preempted);
+
+// Drains the ring over the UART
+void pc_sample_dump(void);
+
+// Samples dropped on a full ring since boot
+std::uint32_t pc_sample_dropped(void);
+
+/**
+ * Marks the next switch as requested by the kernel rather than the tick, so it is not sampled
+ */
+
+inline void pc_sample_yield(void) {
+#ifdef PC_SAMPLING
+	pc_sample_skip = true;
+#endif
+}
+
+#endif /* PC_SAMPLE_H_ */
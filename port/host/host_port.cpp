@@ -0,0 +1,361 @@
+/*
+ * host_port.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <host_port.h>
+#include <scheduler_base.h>
+#include <watchdog.h>
+
+#include <csignal>
+
+#include <chrono>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+/**
+ * Device registers
+ */
+
+volatile std::uint16_t WDTCTL = 0x6904;
+volatile std::uint16_t SFRIE1 = 0;
+host_sfrifg SFRIFG1 = { 0 };
+
+volatile std::uint8_t UCA1CTL1 = UCSWRST;
+volatile std::uint8_t UCA1BR0 = 0;
+volatile std::uint8_t UCA1BR1 = 0;
+volatile std::uint8_t UCA1MCTL = 0;
+volatile std::uint8_t UCA1STAT = 0;
+volatile std::uint8_t UCA1RXBUF = 0;
+host_txbuf UCA1TXBUF;
+volatile std::uint8_t UCA1IE = 0;
+volatile std::uint8_t UCA1IFG = UCTXIFG;	// TXBUF is empty out of reset
+host_iv UCA1IV;
+
+volatile std::uint16_t TA1CTL = 0;
+host_tar TA1R;
+
+volatile std::uint16_t TA0CTL = 0;
+host_ta0r TA0R;
+volatile std::uint16_t TA0CCR0 = 0;
+volatile std::uint16_t TA0CCTL0 = 0;
+
+volatile std::uint8_t P1DIR = 0;
+volatile std::uint8_t P1OUT = 0;
+volatile std::uint8_t P4DIR = 0;
+volatile std::uint8_t P4OUT = 0;
+volatile std::uint8_t P4SEL = 0;
+
+volatile int host_gie = 0;	// GIE is clear out of reset
+
+host_sfrifg &host_sfrifg::operator|=(std::uint16_t flags) {
+	this->value |= flags;
+	host_dispatch();	// As on the device, where the interrupt follows the instruction that raised the flag
+	return *this;
+}
+
+host_sfrifg &host_sfrifg::operator&=(std::uint16_t flags) {
+	this->value &= flags;
+	return *this;
+}
+
+host_sfrifg::operator std::uint16_t() const {
+	return this->value;
+}
+
+static void write_stdout(char c) {
+	(void) ::write(STDOUT_FILENO, &c, 1);
+}
+
+void (*host_uart_transmit)(char c) = write_stdout;
+
+std::size_t host_uart_line_bytes = 0;
+static std::size_t line_sent = 0;			// Bytes the line took this tick
+static volatile std::sig_atomic_t line_due = 0;	// A tick passed since - set from the signal handler, applied with GIE set
+
+host_txbuf &host_txbuf::operator=(std::uint8_t byte) {
+	host_uart_transmit(static_cast<char>(byte));
+
+	if (host_uart_line_bytes == 0 || ++line_sent < host_uart_line_bytes) {
+		UCA1IFG |= UCTXIFG;
+	} else {
+		UCA1STAT |= UCBUSY;	// The line is full for this tick - TXBUF frees up with the next one
+	}
+
+	return *this;
+}
+
+/**
+ * Starts the line's next tick and frees TXBUF if the line held it. Runs before a vector is picked, so the registers
+ * are only touched where an interrupt could be taken anyway.
+ */
+
+static void line_tick(void) {
+	if (!line_due) return;
+
+	line_due = 0;
+	line_sent = 0;
+
+	if (UCA1STAT & UCBUSY) {
+		UCA1STAT &= ~UCBUSY;
+		UCA1IFG |= UCTXIFG;
+	}
+}
+
+host_iv::operator std::uint16_t() const {
+	const std::uint8_t pending = UCA1IE & UCA1IFG;
+
+	if (pending & UCRXIFG) {
+		UCA1IFG &= ~UCRXIFG;
+		return 2;
+	}
+
+	if (pending & UCTXIFG) {
+		UCA1IFG &= ~UCTXIFG;
+		return 4;
+	}
+
+	return 0;
+}
+
+std::uint32_t host_timer_cycles(void) {
+	using host_clock = std::chrono::steady_clock;
+	static host_clock::time_point start = host_clock::now();
+
+	if (TA1CTL & TACLR) {	// TACLR resets the count and clears itself
+		start = host_clock::now();
+		TA1CTL &= ~TACLR;
+	}
+
+	if ((TA1CTL & MC_3) == MC_0) return 0;
+
+	const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(host_clock::now() - start).count();
+	return static_cast<std::uint32_t>(ns * (HOST_SMCLK_HZ / 1e9));
+}
+
+host_tar::operator std::uint16_t() const {
+	return static_cast<std::uint16_t>(host_timer_cycles());
+}
+
+host_ta0r::operator std::uint16_t() const {
+	using host_clock = std::chrono::steady_clock;
+	static host_clock::time_point start = host_clock::now();
+
+	if (TA0CTL & TACLR) {
+		start = host_clock::now();
+		TA0CTL &= ~TACLR;
+	}
+
+	if ((TA0CTL & MC_3) == MC_0) return 0;
+
+	const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(host_clock::now() - start).count();
+	return static_cast<std::uint16_t>(ns * (HOST_ACLK_HZ / 1e9));
+}
+
+void host_uart_receive(char c) {
+	UCA1RXBUF = static_cast<std::uint8_t>(c);
+	UCA1IFG |= UCRXIFG;
+}
+
+/**
+ * Interrupt vectors, in priority order
+ */
+
+extern __attribute__((weak)) void USCI_A1_ISR(void);
+
+static void (*pending_vector(void))(void) {
+	line_tick();
+
+	if ((TA0CCTL0 & CCIE) && (TA0CCTL0 & CCIFG)) {
+		TA0CCTL0 &= ~CCIFG;	// CCR0 clears its own flag when the interrupt is taken
+		return abstract_scheduler::preempt;
+	}
+
+	if ((SFRIE1 & WDTIE) && (SFRIFG1 & WDTIFG)) {
+		SFRIFG1 &= ~WDTIFG;	// Interval mode clears the flag when the interrupt is taken
+		return abstract_scheduler::preempt;
+	}
+	if ((UCA1IE & UCA1IFG) && USCI_A1_ISR != nullptr) return USCI_A1_ISR;
+	return nullptr;
+}
+
+/**
+ * Kernel stack and the context of whoever was interrupted last
+ */
+
+static std::uint8_t kernel_stack[64 * 1024] __attribute__((aligned(16)));
+static ucontext_t kernel;
+static ucontext_t *interrupted = nullptr;
+
+static void kernel_entry(void) {
+	abstract_scheduler::preempt();	// Never comes back - the scheduler resumes a task through ctx_load()
+}
+
+/**
+ * Runs a kernel entry point on the kernel stack, with ticks held off. Never returns.
+ */
+
+static void enter_kernel(void (*entry)(void)) {
+	getcontext(&kernel);
+	kernel.uc_stack.ss_sp = kernel_stack;
+	kernel.uc_stack.ss_size = sizeof(kernel_stack);
+	kernel.uc_link = nullptr;
+	sigaddset(&kernel.uc_sigmask, SIGALRM);	// Ticks only set WDTIFG while the kernel runs
+	makecontext(&kernel, entry, 0);
+
+	setcontext(&kernel);
+}
+
+/**
+ * Takes the scheduler interrupt: parks the current task's registers on its own stack and runs the handler on the
+ * kernel stack. Returns once the scheduler resumes the parked context.
+ */
+
+static void take(void) {
+	ucontext_t here;
+	volatile bool resumed = false;
+
+	getcontext(&here);
+	if (resumed) return;
+	resumed = true;
+
+	interrupted = &here;
+	enter_kernel(kernel_entry);
+}
+
+void host_dispatch(void) {
+	while (host_gie) {
+		void (*handler)(void) = pending_vector();
+		if (handler == nullptr) return;
+
+		host_gie = 0;	// Cleared on interrupt entry, restored by RETI
+
+		// Only the scheduler tick leaves the interrupted stack - drivers run on it, as they do on the device
+		if (handler == abstract_scheduler::preempt) take();
+		else handler();
+
+		host_gie = 1;
+	}
+}
+
+void host_idle(void) {
+	host_gie = 1;	// LPM entry sets GIE along with the clock bits
+	host_dispatch();
+	::pause();		// Sleep until the next tick
+}
+
+/**
+ * Watchdog interval timer - or the Timer_A0 compare with SLICE_TIMER
+ */
+
+static std::uintptr_t tick_pc = 0;
+
+static void tick(int, siginfo_t *, void *uc) {
+#if defined(__x86_64__)
+	tick_pc = static_cast<ucontext_t *>(uc)->uc_mcontext.gregs[REG_RIP];
+#elif defined(__aarch64__)
+	tick_pc = static_cast<ucontext_t *>(uc)->uc_mcontext.pc;
+#endif
+
+#ifdef SLICE_TIMER
+	// Flag the compare if the counter passed CCR0 since the last signal
+	static std::uint16_t last = 0;
+	const std::uint16_t now = TA0R;
+	if (static_cast<std::uint16_t>(TA0CCR0 - last - 1) < static_cast<std::uint16_t>(now - last)) TA0CCTL0 |= CCIFG;
+	last = now;
+#else
+	SFRIFG1 |= WDTIFG;
+#endif
+	line_due = 1;
+	host_dispatch();
+}
+
+static struct host_timer {
+	host_timer() {
+		struct sigaction action = { };
+		action.sa_sigaction = tick;
+		action.sa_flags = SA_RESTART | SA_SIGINFO;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGALRM, &action, nullptr);
+
+		struct itimerval period = { { 0, HOST_TICK_US }, { 0, HOST_TICK_US } };
+		setitimer(ITIMER_REAL, &period, nullptr);
+	}
+} host_timer;
+
+/**
+ * Context backend
+ */
+
+static void task_entry(unsigned hi, unsigned lo) {
+	auto runnable = reinterpret_cast<std::int16_t (*)(void)>(static_cast<std::uintptr_t>((static_cast<std::uint64_t>(hi) << 32) | lo));
+
+	host_gie = 1;	// ctx_load() enables interrupts on the way into a task
+	host_dispatch();
+
+	runnable();
+	for (;;) _low_power_mode_0();	// Nothing to return to - idle until the scheduler retires the task
+}
+
+void host_context_init(host_context &c, std::int16_t (*runnable)(void), void *stack, std::size_t size) {
+	const std::uint64_t entry = reinterpret_cast<std::uintptr_t>(runnable);
+
+	getcontext(&c.start);
+	c.start.uc_stack.ss_sp = stack;
+	c.start.uc_stack.ss_size = size;
+	c.start.uc_link = nullptr;
+	sigemptyset(&c.start.uc_sigmask);
+	makecontext(&c.start, reinterpret_cast<void (*)(void)>(task_entry), 2, static_cast<unsigned>(entry >> 32), static_cast<unsigned>(entry));
+
+	c.resume = &c.start;
+	c.pc = 0;
+}
+
+std::uintptr_t host_context_sp(const host_context &c) {
+	return (c.resume != &c.start) ? reinterpret_cast<std::uintptr_t>(c.resume) : 0;
+}
+
+std::uintptr_t host_context_pc(const host_context &c) {
+	return c.pc;
+}
+
+/**
+ * A tick that arrives with interrupts disabled is taken later, so the PC is that of the tick rather than of the
+ * point the interrupt got through - the device reports the latter
+ */
+
+extern "C" int ctx_save(host_context *env) {
+	env->resume = interrupted;
+	env->pc = tick_pc;
+	return 0;
+}
+
+/**
+ * System call entry - the task's registers stay in a ucontext on its own stack, as with a tick, and the kernel
+ * stack the device port is handed is the port's own
+ */
+
+extern "C" void ctx_trap(host_context *env, void *, void (*entry)(void)) {
+	ucontext_t here;
+	volatile bool resumed = false;
+
+	getcontext(&here);
+	if (resumed) {
+		host_gie = 1;	// ctx_load() enables interrupts on the way back
+		host_dispatch();
+		return;
+	}
+	resumed = true;
+
+	env->resume = &here;
+	env->pc = reinterpret_cast<std::uintptr_t>(__builtin_return_address(0));
+	enter_kernel(entry);
+}
+
+extern "C" void ctx_load(host_context *env) {
+	wdt_reload();
+	setcontext(env->resume);
+}
@@ -0,0 +1,83 @@
+/*
+ * host_port.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef HOST_PORT_H_
+#define HOST_PORT_H_
+
+#include <config.h>
+
+#include <cstdint>
+#include <cstddef>
+
+#include <ucontext.h>
+
+/**
+ * Linux backend of the kernel, selected by building with -DHOST_PORT -Iport/host (see the README). ucontext takes
+ * the place of ctx_swtch.asm and a SIGALRM interval timer stands in for the watchdog interval: every expiry sets
+ * WDTIFG, and pending interrupts are taken as soon as the virtual GIE allows it. Driver handlers run on the
+ * interrupted task's stack; the scheduler tick parks the task's registers there and runs on a kernel stack of its
+ * own, just like context_switch() after enter_kstack().
+ */
+
+#ifdef STATIC_KERNEL
+#error "The host port only supports the heap-allocated kernel - leave STATIC_KERNEL undefined"
+#endif
+
+#ifdef TICKLESS_IDLE
+#error "The host port has no Timer_B0 or low power modes to go tickless with - leave TICKLESS_IDLE undefined"
+#endif
+
+#ifndef HOST_STACK_WORDS
+#define HOST_STACK_WORDS 16384	// Smallest task stack on the host - libc and signal frames need far more than a device task
+#endif
+
+#ifndef HOST_TICK_US
+#define HOST_TICK_US 1953		// WDT_ADLY_1_9 - 64 ACLK cycles
+#endif
+
+#ifndef HOST_ACLK_HZ
+#define HOST_ACLK_HZ 32768		// REFO / XT1 - the rate Timer_A0 counts at
+#endif
+
+#ifndef HOST_SMCLK_HZ
+#define HOST_SMCLK_HZ 1048576	// Default DCO frequency - the rate Timer_A counts at
+#endif
+
+/**
+ * Saved state of a task. A suspended task's registers sit in a ucontext on its own stack, the way the device port
+ * leaves them in the interrupt frame, and resume points at it - or at start for a task that has not run yet.
+ */
+
+struct host_context {
+	ucontext_t *resume;
+	ucontext_t start;
+	std::uintptr_t pc;	// Where the task was when the last tick arrived - the device reads this off the interrupt frame
+};
+
+// Prepares a context that enters runnable on the given stack, with interrupts enabled
+void host_context_init(host_context &c, std::int16_t (*runnable)(void), void *stack, std::size_t size);
+
+// Address the context was suspended at, 0 if it has not run yet
+std::uintptr_t host_context_sp(const host_context &c);
+
+// Program counter the context was suspended at, 0 if it has not run yet
+std::uintptr_t host_context_pc(const host_context &c);
+
+// Timer_A1 count without the 16-bit wrap - the host has no overflow interrupt to extend it with
+std::uint32_t host_timer_cycles(void);
+
+// Delivers a byte on the simulated RXD line - the RX interrupt is taken at the next opportunity
+void host_uart_receive(char c);
+
+// Where bytes written to UCA1TXBUF go, stdout by default
+extern void (*host_uart_transmit)(char c);
+
+// Bytes the simulated TXD line takes per tick, 0 (the default) for no limit. Once they are out, TXBUF stays busy and
+// TXIFG clear until the next tick - 22 is about 115200 baud at the default tick.
+extern std::size_t host_uart_line_bytes;
+
+#endif /* HOST_PORT_H_ */
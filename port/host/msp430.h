@@ -0,0 +1,198 @@
+/*
+ * msp430.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef HOST_MSP430_H_
+#define HOST_MSP430_H_
+
+#include <cstdint>
+
+/**
+ * Stand-in for the TI device header when the kernel is built with HOST_PORT (see host_port.h). Only the registers
+ * and intrinsics the kernel and its drivers touch are modelled: registers are plain memory, except for the UART
+ * transmit buffer and interrupt vector register, which behave like the USCI does, and SFRIFG1. Interrupts are taken
+ * whenever the virtual GIE flag is set and an enabled flag is pending.
+ */
+
+#define interrupt
+#define naked
+#define __interrupt
+
+/**
+ * Special function and watchdog registers
+ */
+
+struct host_sfrifg {
+	host_sfrifg &operator|=(std::uint16_t flags);	// Setting an enabled flag with GIE set takes the interrupt at once
+	host_sfrifg &operator&=(std::uint16_t flags);
+	operator std::uint16_t() const;
+
+	volatile std::uint16_t value;
+};
+
+extern volatile std::uint16_t WDTCTL;
+extern volatile std::uint16_t SFRIE1;
+extern host_sfrifg SFRIFG1;
+
+#define WDTPW			0x5A00
+#define WDTHOLD			0x0080
+#define WDTTMSEL		0x0010
+#define WDTCNTCL		0x0008
+#define WDTSSEL0		0x0020
+#define WDTIS2			0x0004
+#define WDTIS1			0x0002
+#define WDTIS0			0x0001
+#define WDT_ADLY_1_9	(WDTPW + WDTTMSEL + WDTCNTCL + WDTIS2 + WDTIS1 + WDTIS0 + WDTSSEL0)
+
+#define WDTIE			0x0001
+#define WDTIFG			0x0001
+
+/**
+ * USCI_A1 in UART mode
+ */
+
+struct host_txbuf {
+	host_txbuf &operator=(std::uint8_t byte);	// Sends the byte and leaves TXIFG set, unless host_uart_line_bytes holds it
+};
+
+struct host_iv {
+	operator std::uint16_t() const;				// Highest pending enabled flag (2 RX, 4 TX), cleared by the read
+};
+
+extern volatile std::uint8_t UCA1CTL1;
+extern volatile std::uint8_t UCA1BR0;
+extern volatile std::uint8_t UCA1BR1;
+extern volatile std::uint8_t UCA1MCTL;
+extern volatile std::uint8_t UCA1STAT;
+extern volatile std::uint8_t UCA1RXBUF;
+extern host_txbuf UCA1TXBUF;
+extern volatile std::uint8_t UCA1IE;
+extern volatile std::uint8_t UCA1IFG;
+extern host_iv UCA1IV;
+
+#define UCSWRST			0x01
+#define UCSSEL_2		0x80
+#define UCBRS_1			0x02
+#define UCBRF_0			0x00
+#define UCBUSY			0x01
+#define UCRXIE			0x01
+#define UCTXIE			0x02
+#define UCRXIFG			0x01
+#define UCTXIFG			0x02
+
+/**
+ * Timer_A1 - the counter runs at HOST_SMCLK_HZ in any mode but stop, nothing else is modelled
+ */
+
+struct host_tar {
+	operator std::uint16_t() const;
+};
+
+extern volatile std::uint16_t TA1CTL;
+extern host_tar TA1R;
+
+/**
+ * Timer_A0 - the counter runs at HOST_ACLK_HZ in any mode but stop, and CCR0 raises its interrupt when the counter
+ * passes it. Compares are checked on every host timer signal, so they land up to HOST_TICK_US late.
+ */
+
+struct host_ta0r {
+	operator std::uint16_t() const;
+};
+
+extern volatile std::uint16_t TA0CTL;
+extern host_ta0r TA0R;
+extern volatile std::uint16_t TA0CCR0;
+extern volatile std::uint16_t TA0CCTL0;
+
+#define TASSEL_1		0x0100
+#define TASSEL_2		0x0200
+#define ID_0			0x0000
+#define MC_0			0x0000
+#define MC_2			0x0020
+#define MC_3			0x0030
+#define TACLR			0x0004
+#define TAIE			0x0002
+#define TAIFG			0x0001
+#define CCIE			0x0010
+#define CCIFG			0x0001
+
+/**
+ * Digital I/O
+ */
+
+extern volatile std::uint8_t P1DIR;
+extern volatile std::uint8_t P1OUT;
+extern volatile std::uint8_t P4DIR;
+extern volatile std::uint8_t P4OUT;
+extern volatile std::uint8_t P4SEL;
+
+#define BIT0			0x01
+#define BIT1			0x02
+#define BIT2			0x04
+#define BIT3			0x08
+#define BIT4			0x10
+#define BIT5			0x20
+#define BIT6			0x40
+#define BIT7			0x80
+
+/**
+ * Interrupt vectors, only used by #pragma vector (which the host compiler ignores)
+ */
+
+#define USCI_A1_VECTOR	46
+#define WDT_VECTOR		58
+
+/**
+ * Intrinsics
+ */
+
+#define GIE				0x0008
+
+extern volatile int host_gie;
+void host_dispatch(void);
+void host_idle(void);
+
+inline void _disable_interrupt(void) {
+	host_gie = 0;
+}
+
+inline void _enable_interrupt(void) {
+	host_gie = 1;
+	host_dispatch();
+}
+
+inline unsigned short _get_interrupt_state(void) {
+	return host_gie ? GIE : 0;
+}
+
+inline void _set_interrupt_state(unsigned short state) {
+	host_gie = (state & GIE) != 0;
+	host_dispatch();
+}
+
+inline void _low_power_mode_0(void) {
+	host_idle();
+}
+
+inline void _low_power_mode_3(void) {
+	host_idle();
+}
+
+inline void _low_power_mode_4(void) {
+	host_idle();
+}
+
+// The port switches stacks through the saved contexts, so the kernel's own stack juggling becomes a no-op
+inline std::uintptr_t _get_SP_register(void) { return 0; }
+inline void _set_SP_register(std::uintptr_t) { }
+inline std::uintptr_t __get_SP_register(void) { return 0; }
+inline void __set_SP_register(std::uintptr_t) { }
+
+inline unsigned __even_in_range(unsigned x, unsigned) { return x; }
+inline void __no_operation(void) { }
+
+#endif /* HOST_MSP430_H_ */
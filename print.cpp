@@ -7,14 +7,18 @@
 
 #include <print.h>
 #include <scheduler.h>
+#include <wait_queue.h>
+
+#include <algorithm>
+#include <cstring>
 
 extern scheduler<scheduling_algorithms::lottery> os;
 
-ring_buffer<char> rx_fifo(16);
-ring_buffer<char> tx_fifo(4);
+ring_buffer<char, overflow_policy::drop_new> rx_fifo(16);	// Filled by the RX ISR, so it must never touch the read index
+ring_buffer<char, overflow_policy::drop_new> tx_fifo(64);	// Drained by the TX ISR, writers wait for room
+wait_queue tx_waiters;										// Writers blocked on a full tx_fifo
 
 volatile bool rx_scheduled = false;
-volatile bool tx_scheduled = false;
 
 /**
  * Interrupt routine for receiving a character over UART
@@ -35,25 +39,29 @@ __attribute__((interrupt)) void USCI_A1_ISR(void) {
 			P4OUT &= ~BIT7;
 
 			P1OUT |= BIT0;
-			uart_send_byte(recv);
+			tx_fifo.put(recv);	// Echo - dropped rather than waited on if the line is backed up
+			UCA1IE |= UCTXIE;
 			P1OUT &= ~BIT0;
 
 //			if (rx_fifo.full() && !rx_scheduled) {
-//				os.schedule_interrupt((isr) uart_rx_task); // when max(character requests) received, then schedule the rx task
+//				os.schedule_interrupt(USCI_A1_VECTOR); // when max(character requests) received, then schedule the rx task
 //				rx_scheduled = true;
 //			}
 			break;
 		}
 
 		case 4: { // Vector 4 - TXIFG
-
 			if (!tx_fifo.empty()) {
 				P1OUT |= BIT0;
 				uart_send_byte(tx_fifo.get());
 				P1OUT &= ~BIT0;
+
+				if (!tx_waiters.empty() && tx_fifo.size() <= (tx_fifo.capacity() >> 1)) {
+					os.notify_all(tx_waiters);	// Half drained - let the writers refill in one go
+				}
 			} else {
-				UCA1IE &= ~UCTXIE;
-				UCA1IFG &= ~UCTXIFG;
+				UCA1IE &= ~UCTXIE;	// Drained - stop until the next kick
+				UCA1IFG |= UCTXIFG;	// The vector read cleared TXIFG though TXBUF is free - re-arm it for that kick
 			}
 
 			break;
@@ -65,23 +73,10 @@ __attribute__((interrupt)) void USCI_A1_ISR(void) {
 	}
 }
 
-std::int16_t uart_tx_task(void) {
-	while (1) {
-		_disable_interrupt();
-		if (!tx_fifo.empty()) {
-			while (UCA1STAT & UCBUSY);
-			UCA1IE |= UCTXIE;                         // Enable USCI_A0 TX interrupt
-			uart_send_byte(tx_fifo.get());
-		} else {
-			tx_scheduled = false;
-			os.block();
-		}
-		_enable_interrupt();
-	}
-}
-
 std::int16_t uart_rx_task(void) {
 	while (1) {
+		os.wait_interrupt();
+
 		_disable_interrupt();
 		// copy rx characters to all processes waiting
 		_enable_interrupt();
@@ -90,8 +85,6 @@ std::int16_t uart_rx_task(void) {
 		rx_fifo.reset();
 		rx_scheduled = false;
 		_enable_interrupt();
-
-		os.block();
 	}
 }
 
@@ -114,8 +107,60 @@ void uart_init(void) {
 	P1DIR |= BIT0;
 	P1OUT &= ~BIT0;
 
-//	os.attach_interrupt((isr) uart_tx_task, task(uart_tx_task, 32));
-//	os.attach_interrupt((isr) uart_rx_task, task(uart_rx_task, 32));
+//	if (os.attach_interrupt(USCI_A1_VECTOR, task(uart_rx_task, 32)) == nullptr) return;	// No source left
+}
+
+/**
+ * Queues a run of bytes for transmission. They are copied straight into the TX ring and the TXIFG interrupt drains
+ * them in the background, so the caller never waits on the line - it only blocks on tx_waiters while the ring is
+ * full. The ring has two producers, the writers and the RX echo in the ISR, and they are serialized by running the
+ * reservation with interrupts disabled, which is what keeps the ring single-producer. wait() gives the caller's
+ * interrupt state back, so a caller that is already in an interrupts-off section stays in it.
+ **/
+
+void uart_write(const char *data, std::size_t n) {
+	while (n > 0) {
+		std::uint16_t state = _get_interrupt_state();
+		_disable_interrupt();
+
+		ring_region<char> region = tx_fifo.reserve(n);
+		std::copy(data, data + region.first.size, region.first.data);
+		std::copy(data + region.first.size, data + region.size(), region.second.data);
+		tx_fifo.commit(region.size());
+
+		data += region.size();
+		n -= region.size();
+
+		UCA1IE |= UCTXIE;	// Kick the transmitter - TXIFG is pending whenever TXBUF is free
+
+		if (n > 0) os.wait(tx_waiters);	// Full - sleep until the ISR has made room
+
+		_set_interrupt_state(state);
+	}
+}
+
+/**
+ * Reserves n contiguous bytes of the TX ring - at most half of it - for a record that must not be split, waiting on
+ * tx_waiters until they are free. Call it with interrupts disabled and keep them disabled until uart_commit(), as
+ * that is what keeps the ring single-producer.
+ **/
+
+ring_region<char> uart_reserve(std::size_t n) {
+	while (tx_fifo.capacity() - tx_fifo.size() < n) {
+		UCA1IE |= UCTXIE;
+		os.wait(tx_waiters);	// The ISR notifies once the ring is half drained, so the record fits then
+	}
+
+	return tx_fifo.reserve(n);
+}
+
+/**
+ * Publishes the first n reserved bytes and kicks the transmitter
+ **/
+
+void uart_commit(std::size_t n) {
+	tx_fifo.commit(n);
+	UCA1IE |= UCTXIE;
 }
 
 /**
@@ -123,86 +168,43 @@ void uart_init(void) {
  **/
 
 void uart_puts(char *s) {
-	for (char *p = s; *p != 0; p++) uart_putc(*p);
+	uart_write(s, std::strlen(s));
 }
 
 /**
- * uart_puts() is used by printf() to display or send a character
+ * uart_putc() is used by printf() to display or send a character
  **/
 
 void uart_putc(unsigned b) {
-//	if (tx_fifo.full()) {
-//		if (!tx_scheduled) {
-//			os.schedule_interrupt((isr) uart_tx_task);
-//			tx_scheduled = true;
-//		}
-//	}
-//
-//	while (tx_fifo.full());
-//
-//	_disable_interrupt();
-//	tx_fifo.put(b);
-//	if (tx_fifo.full()) {
-//		_enable_interrupt();
-//		while (UCA1STAT & UCBUSY);
-//		UCA1IE |= UCTXIE;                         // Enable USCI_A0 TX interrupt
-//		uart_send_byte(b);
-//	}
-//	_enable_interrupt();
-	while (UCA1STAT & UCBUSY);
-	uart_send_byte(b);
+	const char c = static_cast<char>(b);
+	uart_write(&c, 1);
 }
 
 /**
- * Sends a single byte out through UART
+ * Whether the UART has nothing left to send - it runs off SMCLK, so deep sleep has to wait for it
  **/
 
-void uart_send_byte(unsigned char byte) {
-	UCA1TXBUF = byte;
+bool uart_idle(void) {
+	return tx_fifo.empty() && !(UCA1IE & UCTXIE) && !(UCA1STAT & UCBUSY);
 }
 
-static const unsigned long dv[] = {
-//  4294967296      // 32 bit unsigned max
-		1000000000,// +0
-		100000000, // +1
-		10000000, // +2
-		1000000, // +3
-		100000, // +4
-//       65535      // 16 bit unsigned max
-		10000, // +5
-		1000, // +6
-		100, // +7
-		10, // +8
-		1, // +9
-		};
-
-static void xtoa(unsigned long x, const unsigned long *dp) {
-	char c;
-	unsigned long d;
-	if (x) {
-		while (x < *dp)
-			++dp;
-		do {
-			d = *dp++;
-			c = '0';
-			while (x >= d) {
-				++c;
-				x -= d;
-			}
+/**
+ * Sends a single byte out through UART
+ **/
 
-			uart_putc(c);
-		} while (!(d & 1));
-	} else
-		uart_putc('0');
+void uart_send_byte(unsigned char byte) {
+	UCA1TXBUF = byte;
 }
 
-static void puth(unsigned n) {
-	static const char hex[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8',
-			'9', 'A', 'B', 'C', 'D', 'E', 'F' };
-	uart_putc(hex[n & 15]);
-}
+/**
+ * Runtime-parsed printer for format strings that are not known at compile time - it shares the sink and the digit
+ * emitters with uart_format(), and stages its output 8 bytes at a time into the TX ring
+ **/
 
 void uart_printf(char *format, ...) {
+	char chunk[8];
+	format_sink out(chunk, sizeof(chunk), uart_write);
+
 	char c;
 	int i;
 	long n;
@@ -213,35 +215,35 @@ void uart_printf(char *format, ...) {
 		if (c == '%') {
 			switch (c = *format++) {
 				case 's': // String
-					uart_puts(va_arg(a, char*));
+					out.puts(va_arg(a, char*));
 					break;
 				case 'c':// Char
-					uart_putc(va_arg(a, char));
+					out.put(va_arg(a, int));
 				break;
 				case 'i':// 16 bit Integer
 				case 'u':// 16 bit Unsigned
 					i = va_arg(a, int);
-					if (c == 'i' && i < 0) i = -i, uart_putc('-');
-					xtoa((unsigned)i, dv + 5);
+					if (c == 'i' && i < 0) i = -i, out.put('-');
+					format_udec(out, static_cast<std::uint16_t>(i));
 				break;
 				case 'l':// 32 bit Long
 				case 'n':// 32 bit uNsigned loNg
 					n = va_arg(a, long);
-					if (c == 'l' && n < 0) n = -n, uart_putc('-');
-					xtoa((unsigned long)n, dv);
+					if (c == 'l' && n < 0) n = -n, out.put('-');
+					format_udec(out, static_cast<std::uint32_t>(n));
 				break;
 				case 'x':// 16 bit heXadecimal
 					i = va_arg(a, int);
-					puth(i >> 12);
-					puth(i >> 8);
-					puth(i >> 4);
-					puth(i);
+					format_hex(out, static_cast<std::uint16_t>(i), 4);
 				break;
-				case 0: return;
+				case 0: goto done;
 				default: goto bad_fmt;
 			}
 		} else
-			bad_fmt: uart_putc(c);
+			bad_fmt: out.put(c);
 	}
+
+done:
 	va_end(a);
+	out.finish();
 }
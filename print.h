@@ -10,24 +10,42 @@
 
 #include <msp430.h>
 #include <cstdarg>
+#include <cstddef>
 
 #include <ring_buffer.h>
+#include <format.h>
 
 void uart_putc(unsigned);
+void uart_write(const char *data, std::size_t n);
+ring_region<char> uart_reserve(std::size_t n);
+void uart_commit(std::size_t n);
 void uart_puts(char *);
 void uart_send_byte(unsigned char byte);
 void uart_printf(char *format, ...);
 
 void uart_init(void);
+bool uart_idle(void);
+
+/**
+ * Compile-time checked counterpart of uart_printf - format_string("...") in, no parsing at run time
+ */
+
+template <class Format, class... Args>
+void uart_format(Format f, const Args &... args) {
+	char chunk[8];
+	format_sink out(chunk, sizeof(chunk), uart_write);
+
+	format_to(out, f, args...);
+	out.finish();
+}
 
 std::int16_t uart_rx_task(void);
-std::int16_t uart_tx_task(void);
 
 class uart {
 
 private:
-	ring_buffer<char> tx_fifo;
-	ring_buffer<char> rx_fifo;
+	ring_buffer<char, overflow_policy::drop_new> tx_fifo;
+	ring_buffer<char, overflow_policy::drop_new> rx_fifo;
 };
 
 #endif /* PRINT_H_ */
@@ -0,0 +1,153 @@
+/*
+ * ready_queue.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <ready_queue.h>
+#include <bitops.h>
+
+static_assert(NUM_PRIORITY_LEVELS <= 16, "Priority bitmap is a single 16-bit word");
+
+/**
+ * Default constructor - both banks start out empty
+ */
+
+ready_queue::ready_queue() {
+	this->clear();
+}
+
+/**
+ * Drops every task from both banks
+ */
+
+void ready_queue::clear(void) {
+	for (auto &bank : this->lists) {
+		for (auto &list : bank) {
+			list.head = nullptr;
+			list.tail = nullptr;
+		}
+	}
+
+	this->bitmap[0] = 0;
+	this->bitmap[1] = 0;
+	this->active = 0;
+	this->round = 0;
+}
+
+/**
+ * Run list a task is filed under - priorities past the last level share the top list
+ */
+
+inline std::uint8_t ready_queue::level(const task &t) {
+	const std::uint8_t pri = t.get_priority();
+	return (pri < NUM_PRIORITY_LEVELS) ? pri : NUM_PRIORITY_LEVELS - 1;
+}
+
+/**
+ * Number of consecutive slices a task receives per round
+ */
+
+inline std::uint8_t ready_queue::weight(const task &t) {
+	const std::uint8_t pri = t.get_priority();
+	return (pri > 0) ? pri : 1;
+}
+
+/**
+ * Appends a task to the tail of its run list in the given bank and marks that level as populated
+ */
+
+void ready_queue::link(task &t, std::uint8_t bank) {
+	run_list &list = this->lists[bank][level(t)];
+
+	t.link.next = nullptr;
+	t.link.prev = list.tail;
+	t.link.index = bank;
+	t.link.round = (bank == this->active) ? this->round : static_cast<std::uint16_t>(this->round + 1);
+	t.link.state = link_state::ready;
+
+	if (list.tail != nullptr) list.tail->link.next = &t;
+	else list.head = &t;
+	list.tail = &t;
+
+	this->bitmap[bank] |= (1u << level(t));
+}
+
+/**
+ * Removes a task from its run list and clears the level bit if the list drained
+ */
+
+void ready_queue::unlink(task &t) {
+	const std::uint8_t bank = t.link.index;
+	run_list &list = this->lists[bank][level(t)];
+
+	if (t.link.prev != nullptr) t.link.prev->link.next = t.link.next;
+	else list.head = t.link.next;
+
+	if (t.link.next != nullptr) t.link.next->link.prev = t.link.prev;
+	else list.tail = t.link.prev;
+
+	if (list.head == nullptr) this->bitmap[bank] &= ~(1u << level(t));
+
+	t.link.next = nullptr;
+	t.link.prev = nullptr;
+	t.link.state = link_state::detached;
+}
+
+/**
+ * Makes a task runnable. One coming back within the round it ran in picks up where it left off - the slices it
+ * has left, or the expired bank if it has none for this round. Anyone else joins the current round in full.
+ */
+
+void ready_queue::push(task &t) {
+	if (t.link.state == link_state::ready) return;	// Already queued
+
+	if (t.link.round == static_cast<std::uint16_t>(this->round + 1)) {
+		this->link(t, this->active ^ 1);
+		return;
+	}
+
+	if (t.link.round != this->round || t.link.slices == 0) {
+		t.link.slices = weight(t);
+	}
+
+	this->link(t, this->active);
+}
+
+/**
+ * Takes a task out of the rotation (sleeping, blocking or complete)
+ */
+
+void ready_queue::remove(task &t) {
+	if (t.link.state != link_state::ready) return;
+	this->unlink(t);
+}
+
+/**
+ * Retires a task for the rest of this round and refills its slices for the next one
+ */
+
+void ready_queue::expire(task &t) {
+	if (t.link.state != link_state::ready) return;
+
+	this->unlink(t);
+	t.link.slices = weight(t);
+	this->link(t, this->active ^ 1);
+}
+
+/**
+ * Picks the head of the highest populated level, starting a new round if the active bank is exhausted. Idle
+ * passes leave the round alone, so the counter does not run on while nothing is ready.
+ */
+
+task *ready_queue::front(void) {
+	if (this->bitmap[this->active] == 0) {
+		if (this->bitmap[this->active ^ 1] == 0) return nullptr;
+
+		this->active ^= 1;
+		this->round++;
+	}
+
+	return this->lists[this->active][msb16(this->bitmap[this->active])].head;
+}
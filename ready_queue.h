@@ -0,0 +1,78 @@
+/*
+ * ready_queue.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef READY_QUEUE_H_
+#define READY_QUEUE_H_
+
+#include <task.h>
+#include <config.h>
+
+#include <cstdint>
+
+/**
+ * Constant-time ready queue for the weighted round-robin scheduler.
+ *
+ * Tasks are kept in one FIFO run list per priority level, and a bitmap records which levels are non-empty, so
+ * the next task is found with a single count-leading-zeros. The lists are split into an active and an expired
+ * bank: a task that has used up its weight in slices moves to the expired bank, and the banks swap once the
+ * active one drains. Every task therefore still gets exactly `priority` slices per round.
+ *
+ * The rounds are numbered, and a task remembers the round its slices were handed out for. A task that sleeps or
+ * blocks and comes back within the same round keeps what it had left, or waits in the expired bank if it had spent
+ * its weight - a steady stream of wake-ups can never keep the active bank from draining. Only rounds in which some
+ * task ran are counted, so a task would have to stay away for 65536 of them before its old round number comes up
+ * again, and even then it only sits out a single round.
+ */
+
+class ready_queue {
+public:
+	ready_queue();
+
+	// Makes a task runnable - into the active bank, unless it already spent its weight this round
+	void push(task &t);
+
+	// Unlinks a task from whichever bank holds it
+	void remove(task &t);
+
+	// Moves a task whose slices ran out to the back of the expired bank
+	void expire(task &t);
+
+	// Returns the next task to run, or nullptr if nothing is ready
+	task *front(void);
+
+	// Drops every task
+	void clear(void);
+
+	inline bool empty(void) const;
+
+private:
+	struct run_list {
+		task *head;
+		task *tail;
+	};
+
+	void link(task &t, std::uint8_t bank);
+	void unlink(task &t);
+
+	static inline std::uint8_t level(const task &t);
+	static inline std::uint8_t weight(const task &t);
+
+	run_list lists[2][NUM_PRIORITY_LEVELS];
+	std::uint16_t bitmap[2];
+	std::uint8_t active;
+	std::uint16_t round;	// Bumped at every bank swap that starts a non-empty round, wraps
+};
+
+/**
+ * Asserts if there is no task available in either bank
+ */
+
+inline bool ready_queue::empty(void) const {
+	return (this->bitmap[0] | this->bitmap[1]) == 0;
+}
+
+#endif /* READY_QUEUE_H_ */
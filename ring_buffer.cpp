@@ -10,86 +10,267 @@
 
 #include <ring_buffer.h>
 
-template <class T>
-ring_buffer<T>::ring_buffer() : buf_(std::unique_ptr<T[]>(nullptr)), max_size_(0) { }
+#include <algorithm>
 
-template <class T>
-ring_buffer<T>::ring_buffer(std::size_t size) : buf_(std::unique_ptr<T[]>(new T[size])), max_size_(size) { }
+template <class T, overflow_policy P>
+ring_buffer<T, P>::ring_buffer() : owned_(std::unique_ptr<T[]>(nullptr)), buf_(nullptr), max_size_(0), mask_(0) { }
 
-template <class T>
-ring_buffer<T>::ring_buffer(const ring_buffer<T> &other) {
-	new (this) ring_buffer<T>(max_size_);
+/**
+ * A size of 0 makes an empty buffer that allocates nothing and accepts nothing, as the default constructor does
+ */
+
+template <class T, overflow_policy P>
+ring_buffer<T, P>::ring_buffer(std::size_t size)
+	: owned_(std::unique_ptr<T[]>((size > 0) ? new T[ceil_pow2(size)] : nullptr)), buf_(owned_.get()),
+	max_size_(ceil_pow2(size)), mask_(mask_of(max_size_)) { }
+
+template <class T, overflow_policy P>
+ring_buffer<T, P>::ring_buffer(T *storage, std::size_t size) : owned_(std::unique_ptr<T[]>(nullptr)), buf_(storage),
+	max_size_(floor_pow2(size)), mask_(mask_of(max_size_)) { }
+
+/**
+ * Copies get storage of their own and the other buffer's contents, oldest first - none for an empty buffer
+ */
+
+template <class T, overflow_policy P>
+ring_buffer<T, P>::ring_buffer(const ring_buffer<T, P> &other) : ring_buffer(other.max_size_) {
+	this->copy_from(other);
 }
 
-template <class T>
-ring_buffer<T> &ring_buffer<T>::operator=(const ring_buffer<T> &other) {
-	new (this) ring_buffer<T>(max_size_);
+template <class T, overflow_policy P>
+ring_buffer<T, P> &ring_buffer<T, P>::operator=(const ring_buffer<T, P> &other) {
+	if (this == &other) return *this;
+
+	if (this->max_size_ != other.max_size_ || !this->owned_) {
+		this->owned_.reset((other.max_size_ > 0) ? new T[other.max_size_] : nullptr);
+		this->buf_ = this->owned_.get();
+		this->max_size_ = other.max_size_;
+		this->mask_ = other.mask_;
+	}
+
+	this->copy_from(other);
 	return *this;
 }
 
-template <class T>
-inline void ring_buffer<T>::put(T item) {
-	buf_[head_] = item;	// Write data
+template <class T, overflow_policy P>
+void ring_buffer<T, P>::copy_from(const ring_buffer<T, P> &other) {
+	const std::size_t tail = other.tail_;
+	const std::size_t n = other.head_ - tail;
 
-	if (full_) {	// If full, must drop the oldest element
-		if (++tail_ == max_size_) tail_ = 0;	// Modulo increment
+	for (std::size_t i = 0; i < n; ++i) {
+		this->buf_[i] = other.buf_[(tail + i) & other.mask_];
 	}
 
-	if (++head_ == max_size_) head_ = 0; 		// Modulo increment
+	this->tail_ = 0;
+	this->head_ = n;
+}
+
+template <class T, overflow_policy P>
+inline bool ring_buffer<T, P>::put(T item) {
+	if (this->max_size_ == 0) return false;
+
+	if (this->full()) {
+		switch (P) {
+			case overflow_policy::drop_new: return false;
+			case overflow_policy::drop_old: this->tail_ = this->tail_ + 1; break;	// Give up the oldest element
+			case overflow_policy::block: while (this->full()); break;				// Wait for the consumer
+		}
+	}
+
+	const std::size_t head = this->head_;
+	this->buf_[head & this->mask_] = item;	// Write data
 
-	full_ = (head_ == tail_);	// Update status
+	std::atomic_signal_fence(std::memory_order_release);	// Data must land before the slot is published
+	this->head_ = head + 1;
+
+	return true;
 }
 
-template <class T>
-inline T ring_buffer<T>::get() {
-	if (empty()) {	// If empty, return NULL
+template <class T, overflow_policy P>
+inline T ring_buffer<T, P>::get() {
+	const std::size_t tail = this->tail_;
+	if (tail == this->head_) {	// If empty, return NULL
 		return T();
 	}
 
-	// Read data and advance the tail (we now have a free space)
-	auto val = buf_[tail_];
-	full_ = false;
-	if (++tail_ == max_size_) tail_ = 0;	// Modulo increment
+	std::atomic_signal_fence(std::memory_order_acquire);	// Do not read the slot before seeing it published
+	auto val = this->buf_[tail & this->mask_];
+
+	std::atomic_signal_fence(std::memory_order_release);	// Finish the read before the slot is handed back
+	this->tail_ = tail + 1;
 
 	return val;
 }
 
-template <class T>
-inline void ring_buffer<T>::reset() {
-	head_ = tail_;	// Sets the size to zero
-	full_ = false;
+/**
+ * Pushes up to n items with at most two block copies. drop_new stores what fits, drop_old keeps the newest
+ * capacity() items and block waits for room until everything is in.
+ */
+
+template <class T, overflow_policy P>
+std::size_t ring_buffer<T, P>::put_n(const T *items, std::size_t n) {
+	if (this->max_size_ == 0) return 0;
+
+	std::size_t done = 0;
+
+	switch (P) {
+		case overflow_policy::drop_new: {
+			done = std::min(n, this->max_size_ - this->size());
+			this->publish(items, done);
+			break;
+		}
+
+		case overflow_policy::drop_old: {
+			done = n;
+			if (n > this->max_size_) {	// Only the newest capacity() items could survive anyway
+				items += n - this->max_size_;
+				n = this->max_size_;
+			}
+
+			const std::size_t room = this->max_size_ - this->size();
+			if (n > room) this->tail_ = this->tail_ + (n - room);	// Make room by discarding the oldest
+
+			this->publish(items, n);
+			break;
+		}
+
+		case overflow_policy::block: {
+			while (done < n) {
+				const std::size_t chunk = std::min(n - done, this->max_size_ - this->size());
+				this->publish(items + done, chunk);
+				done += chunk;
+			}
+			break;
+		}
+	}
+
+	return done;
+}
+
+/**
+ * Pops up to n items with at most two block copies
+ */
+
+template <class T, overflow_policy P>
+std::size_t ring_buffer<T, P>::get_n(T *items, std::size_t n) {
+	n = std::min(n, this->size());
+	this->consume(items, n);
+	return n;
 }
 
-template <class T>
-inline bool ring_buffer<T>::empty() const {
+/**
+ * Hands out up to n free slots starting at the head. Nothing is visible to the consumer until commit().
+ */
+
+template <class T, overflow_policy P>
+ring_region<T> ring_buffer<T, P>::reserve(std::size_t n) {
+	n = std::min(n, this->max_size_ - this->size());
+	return this->split(this->buf_, this->head_, n);
+}
+
+template <class T, overflow_policy P>
+void ring_buffer<T, P>::commit(std::size_t n) {
+	std::atomic_signal_fence(std::memory_order_release);	// Data must land before the slots are published
+	this->head_ = this->head_ + n;
+}
+
+/**
+ * Exposes up to n filled slots starting at the tail. They stay owned by the consumer until release().
+ */
+
+template <class T, overflow_policy P>
+ring_region<const T> ring_buffer<T, P>::peek(std::size_t n) const {
+	n = std::min(n, this->size());
+	std::atomic_signal_fence(std::memory_order_acquire);	// Do not read the slots before seeing them published
+	return this->split(static_cast<const T *>(this->buf_), this->tail_, n);
+}
+
+template <class T, overflow_policy P>
+void ring_buffer<T, P>::release(std::size_t n) {
+	std::atomic_signal_fence(std::memory_order_release);	// Finish the reads before the slots are handed back
+	this->tail_ = this->tail_ + n;
+}
+
+template <class T, overflow_policy P>
+template <class U>
+ring_region<U> ring_buffer<T, P>::split(U *buf, std::size_t index, std::size_t n) const {
+	const std::size_t start = index & this->mask_;
+	const std::size_t first = std::min(n, this->max_size_ - start);	// Run up to the physical end of the array
+
+	ring_region<U> region = { { buf + start, first }, { buf, n - first } };
+	return region;
+}
+
+template <class T, overflow_policy P>
+void ring_buffer<T, P>::publish(const T *items, std::size_t n) {
+	if (n == 0) return;
+
+	ring_region<T> region = this->reserve(n);
+	std::copy(items, items + region.first.size, region.first.data);
+	std::copy(items + region.first.size, items + region.size(), region.second.data);	// Wrapped remainder
+
+	this->commit(region.size());
+}
+
+template <class T, overflow_policy P>
+void ring_buffer<T, P>::consume(T *items, std::size_t n) {
+	if (n == 0) return;
+
+	ring_region<const T> region = this->peek(n);
+	std::copy(region.first.begin(), region.first.end(), items);
+	std::copy(region.second.begin(), region.second.end(), items + region.first.size);
+
+	this->release(region.size());
+}
+
+template <class T, overflow_policy P>
+inline void ring_buffer<T, P>::reset() {
+	this->tail_ = this->head_;	// Sets the size to zero
+}
+
+template <class T, overflow_policy P>
+inline bool ring_buffer<T, P>::empty() const {
 	// If head and tail are equal, we are empty
-	return (!full_ && (head_ == tail_));
+	return (this->head_ == this->tail_);
 }
 
-template <class T>
-inline bool ring_buffer<T>::full() const {
-	// If tail is ahead the head by 1, we are full
-	return full_;
+template <class T, overflow_policy P>
+inline bool ring_buffer<T, P>::full() const {
+	// If the head is a whole lap ahead of the tail, we are full
+	return (this->size() >= this->max_size_);
 }
 
-template <class T>
-inline std::size_t ring_buffer<T>::capacity() const {
-	return max_size_;
+template <class T, overflow_policy P>
+inline std::size_t ring_buffer<T, P>::capacity() const {
+	return this->max_size_;
 }
 
-template <class T>
-std::size_t ring_buffer<T>::size() const {
-	std::size_t size = max_size_;
+template <class T, overflow_policy P>
+inline std::size_t ring_buffer<T, P>::size() const {
+	return (this->head_ - this->tail_);	// Free-running indices, unsigned wrap does the rest
+}
 
-	if (!full_) {	// Does some pointer arithmetic depending on the locations of stuff
-		if (head_ >= tail_) {
-			size = head_ - tail_;
-		} else {
-			size = max_size_ + head_ - tail_;
-		}
-	}
+template <class T, overflow_policy P>
+std::size_t ring_buffer<T, P>::ceil_pow2(std::size_t size) {
+	if (size == 0) return 0;
+
+	std::size_t p = 1;
+	while (p < size) p <<= 1;
+	return p;
+}
+
+template <class T, overflow_policy P>
+std::size_t ring_buffer<T, P>::floor_pow2(std::size_t size) {
+	if (size == 0) return 0;
+
+	std::size_t p = 1;
+	while ((p << 1) != 0 && (p << 1) <= size) p <<= 1;
+	return p;
+}
 
-	return size;
+template <class T, overflow_policy P>
+std::size_t ring_buffer<T, P>::mask_of(std::size_t capacity) {
+	return (capacity > 0) ? capacity - 1 : 0;
 }
 
 #endif
@@ -9,24 +9,83 @@
 #define RING_BUFFER_H_
 
 #include <cstdint>
+#include <cstddef>
 
+#include <atomic>
 #include <memory>
 
-// Ring buffer class for kernel data structures
+/**
+ * What put() does when the buffer has no free slot
+ */
+
+enum class overflow_policy : std::uint8_t {
+	drop_new,	// Reject the incoming element and leave the buffer untouched
+	drop_old,	// Overwrite the oldest element - the producer moves the read index, see below
+	block		// Spin until the consumer frees a slot - only valid if the consumer can preempt the producer
+};
+
+/**
+ * Contiguous run of slots inside a ring buffer
+ */
 
 template <class T>
+struct ring_span {
+	T *data;
+	std::size_t size;
+
+	T *begin() const { return data; }
+	T *end() const { return data + size; }
+};
+
+/**
+ * A region of a ring buffer as at most two runs - second is only non-empty when the region wraps past the end
+ */
+
+template <class T>
+struct ring_region {
+	ring_span<T> first;
+	ring_span<T> second;
+
+	std::size_t size() const { return first.size + second.size; }
+};
+
+/**
+ * Ring buffer class for kernel data structures. It is a single-producer / single-consumer queue: one side (e.g. an
+ * ISR) only ever puts and the other (e.g. a task) only ever gets, and neither needs interrupts disabled. The
+ * indices run freely and are masked into a power-of-two sized array, so size is always head - tail and full and
+ * empty need no extra flag.
+ *
+ * drop_old is the one exception to the single-writer rule, since the producer has to advance the read index. Use it
+ * only when the producer cannot interrupt a get() in progress (e.g. the consumer runs with interrupts disabled).
+ *
+ * Drivers can skip the per-element calls altogether: the producer reserve()s free slots, fills them in place and
+ * commit()s, the consumer peek()s at filled slots, drains them (or points DMA at them) and release()s. Reservations
+ * never overwrite anything, whatever the overflow policy - they only hand out what is free at the time.
+ */
+
+template <class T, overflow_policy P = overflow_policy::drop_old>
 class ring_buffer {
 public:
 	ring_buffer();
-	ring_buffer(std::size_t size);
+	ring_buffer(std::size_t size);				// Rounded up to a power of two
+	ring_buffer(T *storage, std::size_t size);	// Runs on caller-provided memory, rounded down to a power of two
 
 	ring_buffer(const ring_buffer &other);
 	ring_buffer &operator=(const ring_buffer &other);
 
-	inline void put(T item);	// Push
-	inline T get();				// Pop
+	inline bool put(T item);	// Push, false if the item was dropped
+	inline T get();				// Pop, T() when empty
+
+	std::size_t put_n(const T *items, std::size_t n);	// Bulk push, returns the number of items accepted
+	std::size_t get_n(T *items, std::size_t n);			// Bulk pop, returns the number of items read
 
-	inline void reset();		// Clear
+	ring_region<T> reserve(std::size_t n);				// Producer: up to n free slots to write in place
+	void commit(std::size_t n);							// Producer: publish the first n reserved slots
+
+	ring_region<const T> peek(std::size_t n) const;	// Consumer: up to n filled slots to read in place
+	void release(std::size_t n);						// Consumer: hand the first n peeked slots back
+
+	inline void reset();		// Clear (consumer side)
 
 	inline bool empty() const;
 	inline bool full() const;
@@ -35,11 +94,24 @@ public:
 	inline std::size_t size() const;
 
 private:
-	std::unique_ptr<T[]> buf_;
-	std::size_t head_ = 0;
-	std::size_t tail_ = 0;
-	const std::size_t max_size_;
-	bool full_ = 0;
+	void copy_from(const ring_buffer &other);
+
+	void publish(const T *items, std::size_t n);	// Copy in at the head, then release the slots to the consumer
+	void consume(T *items, std::size_t n);			// Copy out from the tail, then hand the slots back
+
+	template <class U>
+	ring_region<U> split(U *buf, std::size_t index, std::size_t n) const;	// n slots from index, cut at the wrap
+
+	static std::size_t ceil_pow2(std::size_t size);		// 0 stays 0
+	static std::size_t floor_pow2(std::size_t size);
+	static std::size_t mask_of(std::size_t capacity);
+
+	std::unique_ptr<T[]> owned_;	// Empty when running on caller-provided memory
+	T *buf_;
+	std::size_t max_size_;
+	std::size_t mask_;
+	volatile std::size_t head_ = 0;	// Written by the producer only
+	volatile std::size_t tail_ = 0;	// Written by the consumer only (save for drop_old)
 };
 
 #include <ring_buffer.cpp>
@@ -12,15 +12,19 @@
 #include <task.h>
 #include <scheduler_base.h>
 #include <scheduler.h>
+#include <task_table.h>
+#include <switch_profile.h>
+#include <pc_sample.h>
+#include <cpu_time.h>
+#include <tickless.h>
+#include <slice_timer.h>
 
 /**
  * Constructs a scheduler from the specialization implemented in the level above in the hierarchy
  */
 
 template <scheduling_algorithms alg>
-scheduler<alg>::scheduler() {
-	base_scheduler<alg>::base_scheduler(); // Call super constructor
-}
+scheduler<alg>::scheduler() : base_scheduler<alg>() { }
 
 /**
  * Constructs a scheduler given a task list, but also initializes the stack pointer for the OS after
@@ -32,40 +36,126 @@ scheduler<alg>::scheduler(const std::initializer_list<task> &task_list) : base_s
 }
 
 /**
- * Adds a process to the set of processes. Also implemented in the upper level
+ * Adds a process to the set of processes. The task is copied once into a TCB of its own, which is returned -
+ * it is never moved again, so the pointer stays valid until the task is cleaned up. nullptr if the scheduler
+ * holds MAX_TASKS tasks already.
+ */
+
+template <scheduling_algorithms alg>
+task *scheduler<alg>::add_task(const task &t) {
+	this->reap();	// Give the heap back what retired tasks held before taking more
+
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	task *tcb = &this->spawn(t);
+	if (!this->attach(*tcb)) {
+		this->discard(*tcb);
+		tcb = nullptr;
+	}
+
+	_set_interrupt_state(state);
+	return tcb;
+}
+
+/**
+ * Adds a process built in place from its entry point, skipping the copy entirely
  */
 
 template <scheduling_algorithms alg>
-void scheduler<alg>::add_task(const task &t) {
-	base_scheduler<alg>::add_task(t); // Call super.add()
-	this->num_tasks++;
+task *scheduler<alg>::add_task(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t priority) {
+	this->reap();
+
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	task *tcb = &this->spawn(runnable, stack_size, priority);
+	if (!this->attach(*tcb)) {
+		this->discard(*tcb);
+		tcb = nullptr;
+	}
+
+	_set_interrupt_state(state);
+	return tcb;
 }
 
 /**
- * Removes a process from the set of processes
+ * Removes a process from the set of processes in constant time. Its TCB is released if the scheduler owns it, by
+ * a later add_task() or cleanup() - never here, since a task may be cleaning itself up on the stack that goes with
+ * it. Such a task is never scheduled again but runs on until the next switch, and should make no further kernel
+ * calls; ret() is the way for a task to end itself. Called from tasks only - the context switch retires completed
+ * tasks itself.
  */
 
 template <scheduling_algorithms alg>
 void scheduler<alg>::cleanup(const task &t) {
-	base_scheduler<alg>::cleanup(t); // Call super.cleanup()
-	this->num_tasks--;
+	this->reap();	// Before this one is queued
+
+	task &target = const_cast<task &>(t);
+	if (!target.link.enlisted) return;
+
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	this->retire(target);
+
+	_set_interrupt_state(state);
+}
+
+/**
+ * Unlinks a task from the algorithm, its interrupt vector and the registry - interrupts must be disabled. The
+ * current process stays current until the next decision, so the switch can still park it.
+ */
+
+template <scheduling_algorithms alg>
+inline void scheduler<alg>::retire(task &target) {
+	this->detach(target);
+	this->release_handler(target);
+	this->delist(target);
+
+	if (target.link.owned) this->bury(target);
 }
 
 extern void driver_init(void);								// Driver initialization function provided by user
 
 template <scheduling_algorithms alg>
-void scheduler<alg>::init(void) {
+bool scheduler<alg>::init(void) {
 	driver_init();	// Initialize the hardware
 
 	/**
-	 * Iterate through the task list and add it to the underlying process container
+	 * Reject the configuration outright if the scheduler cannot guarantee it
 	 */
 
 	constexpr auto num_cfgs = sizeof(task_cfgs) / sizeof(struct task_config);
+	if (!this->admit(task_cfgs, num_cfgs)) return false;
+
+#ifdef STATIC_KERNEL
+	/**
+	 * Tasks and stacks were laid out at compile time - hand them to the scheduler in place
+	 */
+
+	for (task *it = static_tasks; it < static_tasks + num_static_tasks; ++it) {
+		this->enlist(*it);
+		if (!this->attach(*it)) return false;
+	}
+#else
+	/**
+	 * Iterate through the task list and add it to the underlying process container
+	 */
+
 	const struct task_config *end_pt = task_cfgs + num_cfgs;
 	for (struct task_config *it = const_cast<struct task_config *>(task_cfgs); it < end_pt; ++it) {
-		this->add_task(task(it->func, it->stack_size, it->priority));
+		task &t = this->spawn(it->func, it->stack_size, it->priority);
+		t.set_timing(it->period, it->wcet, it->deadline);
+		t.set_quantum(it->quantum);
+		if (!this->attach(t)) {
+			this->discard(t);
+			return false;
+		}
 	}
+#endif
+
+	return true;
 }
 
 /**
@@ -80,10 +170,26 @@ void scheduler<alg>::start(void) {
 	// Perform any additional initializations, if needed, in the superclass
 	base_scheduler<alg>::start();
 
+#ifdef SWITCH_PROFILING
+	switch_profile_init();
+#endif
+#ifdef CPU_ACCOUNTING
+	cpu_time_init();	// After the profiler - the overflow interrupt rides on the same timer
+#endif
+#ifdef SLICE_TIMER
+	slice_timer_init();
+#endif
+
 	watchdog_init();
 
 	// Schedule and load the first task
 	task &first = this->schedule();
+#ifdef SLICE_TIMER
+	slice_timer_arm(first.get_quantum(), this->get_next_wakeup());
+#endif
+#ifdef CPU_ACCOUNTING
+	cpu_time_switch_in(first, false);
+#endif
 	first.load();
 }
 
@@ -99,25 +205,80 @@ void scheduler<alg>::start(const std::initializer_list<task> &task_list) {
 }
 
 /**
- * Performs a context switch
+ * Performs a context switch - the interrupted task's registers are already on its stack, in the frame. Kernel time
+ * only moves on when the watchdog interval ran out; switches the kernel requested take none of their own. With
+ * SLICE_TIMER the ticks are caught up on from Timer_A0 in dispatch() instead.
+ *
+ * Only round robin can hand the task straight back, so only it takes the tick here, on the task's stack, ahead of
+ * keep_current(). The other algorithms leave the tick to dispatch(), which runs on the kernel stack.
  */
 
+extern bool watchdog_ticked(void);
+
 template <scheduling_algorithms alg>
-inline void scheduler<alg>::context_switch(void) {
+inline void scheduler<alg>::context_switch(void *frame) {
+	switch_stamp(switch_entry);
 	_disable_interrupt();	// Enter critical section
-	this->save_context();	// Save current task context
+	this->save_context(frame);	// Save current task context
+	switch_stamp(switch_saved);
+#ifndef SLICE_TIMER
+	if (alg == scheduling_algorithms::round_robin) {
+		if (watchdog_ticked()) this->tick();
+
+		if (this->keep_current()) {	// Picked again - it can go on right from its own stack
+			this->resume_current();
+		}
+	} else {
+		this->tick_due = watchdog_ticked();
+	}
+#endif
 	this->enter_kstack();	// Switch to the OS stack
-	this->service_interrupts(); // Service interrupts
+	this->dispatch();
+}
+
+/**
+ * Makes the scheduling decision and loads the next task - runs on the kernel stack, with the outgoing task saved
+ */
+
+template <scheduling_algorithms alg>
+inline void scheduler<alg>::dispatch(void) {
+#ifndef SLICE_TIMER
+	if (this->tick_due) {	// Left here by context_switch() - system calls never set it
+		this->tick_due = false;
+		this->tick();
+	}
+#endif
+#ifdef CPU_ACCOUNTING
+	cpu_time_switch_out(this->get_current_process());	// The slice ends here, the rest is kernel time
+#endif
+#ifdef PC_SAMPLING
+	pc_sample_take(this->get_current_process());	// Where the tick found the outgoing task
+#endif
+#ifdef TICKLESS_IDLE
+	this->catch_up(tickless_resume());	// Ticks that went by while the idle hook had the tick stopped
+#endif
+#ifdef SLICE_TIMER
+	this->catch_up(slice_timer_elapsed());	// The slice may have lasted several ticks
+#endif
+
+	if (this->current_process != nullptr && this->current_process->complete()) {	// Retire the outgoing process
+		this->retire(*this->current_process);	// Freed later by a task - never from the interrupt
+	}
 
-	if (this->isr_sched_queue.size() > 0) {	// If any interrupts available to be handled, handle them instead
-		task &driver_handler = const_cast<task &>(this->isr_sched_queue.top());
-		this->current_process = &driver_handler;
-		this->restore_context(driver_handler);
+	task *driver_handler = this->next_handler();
+	if (driver_handler != nullptr) {	// If any interrupts available to be handled, handle them instead
+		this->current_process = driver_handler;
+		switch_stamp(switch_scheduled);
+#ifdef CPU_ACCOUNTING
+		cpu_time_switch_in(*driver_handler, true);
+#endif
+		this->restore_context(*driver_handler);
 	} else {	// Else handle normal processes
 		task &runnable = this->schedule();	// Determine the next process to run
-		if (this->get_current_process().complete()) {
-			this->cleanup(this->get_current_process());
-		}
+		switch_stamp(switch_scheduled);
+#ifdef CPU_ACCOUNTING
+		cpu_time_switch_in(runnable, false);
+#endif
 
 		this->restore_context(runnable);	// Select that process and load it
 	}
@@ -128,8 +289,8 @@ inline void scheduler<alg>::context_switch(void) {
  */
 
 template <scheduling_algorithms alg>
-inline void scheduler<alg>::save_context(void) {
-	this->get_current_process().pause();
+inline void scheduler<alg>::save_context(void *frame) {
+	this->get_current_process().park(frame);
 }
 
 /**
@@ -138,9 +299,35 @@ inline void scheduler<alg>::save_context(void) {
 
 template <scheduling_algorithms alg>
 inline void scheduler<alg>::restore_context(task &runnable) {
+#ifdef SLICE_TIMER
+	// The idle hook has nothing to be preempted for but the next sleeper
+	slice_timer_arm((&runnable == &task::idle_hook) ? slice_max_ticks : runnable.get_quantum(), this->get_next_wakeup());
+#endif
+	switch_stamp(switch_loaded);
+#ifdef SWITCH_PROFILING
+	switch_profile_record(false);	// Past the last stamp, so the bookkeeping stays out of the figures
+#endif
 	runnable.load();
 }
 
+/**
+ * Returns the preempted task to its frame once keep_current() has taken the tick for it. The kernel stack, the
+ * CPU time bookkeeping and the load are skipped - its slice simply goes on, kernel time included.
+ */
+
+template <scheduling_algorithms alg>
+inline void scheduler<alg>::resume_current(void) {
+#ifdef PC_SAMPLING
+	pc_sample_take(this->get_current_process());
+#endif
+	switch_stamp(switch_scheduled);
+	switch_stamp(switch_loaded);
+#ifdef SWITCH_PROFILING
+	switch_profile_record(true);
+#endif
+	this->get_current_process().resume();
+}
+
 #if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
 /**
  * Switches to the OS-reserved stack by switching to the top of its stack
@@ -184,12 +371,17 @@ inline void scheduler<alg>::leave_kstack(const std::uint16_t new_sp) {
 #endif
 
 /**
- * Calls the underlying scheduler implementation to determine a task
+ * Calls the underlying scheduler implementation to determine a task. A periodic job that is past its deadline while
+ * it still runs, or is only now picked, is counted as a miss here rather than when it eventually completes.
  */
 
 template <scheduling_algorithms alg>
 task &scheduler<alg>::schedule(void) {
-	return base_scheduler<alg>::schedule();
+	if (this->current_process != nullptr) this->check_deadline(*this->current_process);
+
+	task &next = base_scheduler<alg>::schedule();
+	this->check_deadline(next);
+	return next;
 }
 
 /**
@@ -222,7 +414,25 @@ extern void watchdog_request(void);
 
 template <scheduling_algorithms alg>
 inline void scheduler<alg>::request_preemption(void) {
+	pc_sample_yield();
+#ifdef SYSCALL_TRAP
+	this->trap();
+#else
 	watchdog_request();
+#endif
+}
+
+/**
+ * Enters the kernel by a plain call. Only the callee-saved registers, SP and the return address need saving -
+ * the compiler already treats the rest as clobbered across a call, and the task is resumed right behind it with
+ * interrupts enabled. Never called from an ISR.
+ */
+
+template <scheduling_algorithms alg>
+void scheduler<alg>::trap(void) {
+	switch_stamp(switch_entry);
+	_disable_interrupt();	// Enter critical section
+	this->get_current_process().trap(reinterpret_cast<void *>(this->kstack_ptr), &abstract_scheduler::syscall);
 }
 
 template <scheduling_algorithms alg>
@@ -236,44 +446,211 @@ void scheduler<alg>::suspend(void) {
 
 template <scheduling_algorithms alg>
 void scheduler<alg>::sleep(const std::size_t ticks) {
+	std::uint16_t state = _get_interrupt_state();
 	_disable_interrupt();	// Enter critical section
 
-	// Set the sleep counter up for the calling process
-	this->get_current_process().sleep(ticks);
+	// Set the sleep counter up for the calling process and park it on the sleep list
+	task &current = this->get_current_process();
+	current.sleep(ticks);
+	if (current.sleeping()) {
+		this->dequeue(current);
+		this->sleepers.insert(current);
+	}
+
 	this->request_preemption();
 
-	_enable_interrupt();
+	_enable_interrupt();	// The switch is taken here
+	_set_interrupt_state(state);
 }
 
 template <scheduling_algorithms alg>
 void scheduler<alg>::block(void) {
+	std::uint16_t state = _get_interrupt_state();
 	_disable_interrupt();	// Enter critical section
 
-	// Set the blocking flag on the current process
+	// Set the blocking flag on the current process and take it off the ready set
 	this->get_current_process().block();
+	this->dequeue(this->get_current_process());
 	this->request_preemption();
 
-	_enable_interrupt();
+	_enable_interrupt();	// The switch is taken here
+	_set_interrupt_state(state);
 }
 
 template <scheduling_algorithms alg>
 void scheduler<alg>::ret(void) {
+	std::uint16_t state = _get_interrupt_state();
 	_disable_interrupt();	// Enter critical section
 
-	// Set the complete flag on the current process
+	// Set the complete flag on the current process and take it off the ready set
 	this->get_current_process().ret();
+	this->dequeue(this->get_current_process());
+	this->request_preemption();
+
+	_enable_interrupt();	// The switch is taken here
+	_set_interrupt_state(state);
+}
+
+/**
+ * Completes the current job of a periodic task. A job that finished past its deadline is counted as a miss unless
+ * schedule() caught it already, and the task sleeps until the next release on its period grid - right away if it
+ * has already overrun into it.
+ */
+
+template <scheduling_algorithms alg>
+void scheduler<alg>::next_period(void) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();	// Enter critical section
+
+	task &current = this->get_current_process();
+	const std::uint32_t now = this->get_tick_count();
+
+	this->check_deadline(current);
+
+	const std::uint32_t next_release = current.get_state().release + current.get_state().period;
+	const std::int32_t wait = static_cast<std::int32_t>(next_release - now);
+
+	this->dequeue(current);
+	current.release(next_release);
+
+	if (wait > 0) {
+		current.sleep(static_cast<std::size_t>(wait));
+		this->sleepers.insert(current);
+	} else {
+		this->enqueue(current);	// Requeue under the new deadline
+	}
+
+	this->request_preemption();
+
+	_enable_interrupt();	// The switch is taken here
+	_set_interrupt_state(state);
+}
+
+/**
+ * Blocks the current process on a wait queue. Callers that test a condition first should do so with interrupts
+ * disabled, so a notification cannot slip in between the test and the wait - they get them back disabled once
+ * notified, so the condition can be tested again just as safely.
+ */
+
+template <scheduling_algorithms alg>
+void scheduler<alg>::wait(wait_queue &queue) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();	// Enter critical section
+
+	// Set the blocking flag on the current process, take it off the ready set and park it on the queue
+	task &current = this->get_current_process();
+	current.block();
+	this->dequeue(current);
+	queue.push(current);
 	this->request_preemption();
 
-	_enable_interrupt();
+	_enable_interrupt();	// The switch is taken here
+	_set_interrupt_state(state);
+}
+
+/**
+ * Ends the current activation of the calling handler. Interrupts caught meanwhile start the next one at once,
+ * otherwise the handler blocks until its vector is raised. Returns how many interrupts the new activation covers.
+ */
+
+template <scheduling_algorithms alg>
+std::uint16_t scheduler<alg>::wait_interrupt(void) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();	// Enter critical section
+
+	task &current = this->get_current_process();
+	const std::uint8_t s = current.link.source;
+
+	if (s >= this->num_sources || this->isr_sources[s].handler != &current) {	// Not a handler
+		_set_interrupt_state(state);
+		return 0;
+	}
+
+	if (this->irq_pending & this->irq_bit(s)) {
+		this->take_interrupts(s);
+	} else {
+		current.block();
+		this->irq_running &= ~this->irq_bit(s);
+		this->request_preemption();
+
+		_enable_interrupt();	// next_handler() hands the activation over before switching back here
+		_disable_interrupt();
+	}
+
+	// Looked up again - attaching another handler may have moved the source
+	const std::uint16_t count = this->isr_sources[current.link.source].taken;
+
+	_set_interrupt_state(state);
+	return count;
 }
 
 /**
- * Unblocks a process when requested
+ * Unblocks a process when requested - safe to call from ISRs
  */
 
 template <scheduling_algorithms alg>
 void scheduler<alg>::unblock(task &target) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();	// Enter critical section
+
+	// Clear the blocking flag and hand the task back to the ready set
 	target.unblock();
+	this->enqueue(target);
+
+	_set_interrupt_state(state);
+}
+
+/**
+ * Hands the longest waiting process on a queue back to the ready set. Leaves the interrupt state as it found it,
+ * so drivers can call it from their ISRs.
+ */
+
+template <scheduling_algorithms alg>
+void scheduler<alg>::notify_one(wait_queue &queue) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	task *waiter = queue.pop();
+	if (waiter != nullptr) {
+		waiter->unblock();
+		this->enqueue(*waiter);
+	}
+
+	_set_interrupt_state(state);
+}
+
+/**
+ * Hands every process waiting on a queue back to the ready set
+ */
+
+template <scheduling_algorithms alg>
+void scheduler<alg>::notify_all(wait_queue &queue) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	for (task *waiter = queue.pop(); waiter != nullptr; waiter = queue.pop()) {
+		waiter->unblock();
+		this->enqueue(*waiter);
+	}
+
+	_set_interrupt_state(state);
+}
+
+/**
+ * Reweights a task - it leaves and rejoins the ready set so the scheduler picks up the new priority
+ */
+
+template <scheduling_algorithms alg>
+void scheduler<alg>::set_priority(task &target, const std::uint8_t priority) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();	// Enter critical section
+
+	const bool queued = (target.link.state == link_state::ready);
+	if (queued) this->dequeue(target);
+	target.set_priority(priority);
+	if (queued) this->enqueue(target);
+
+	_set_interrupt_state(state);
 }
 
 #endif
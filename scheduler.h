@@ -12,6 +12,7 @@
 #include <config.h>
 #include <task.h>
 #include <scheduler_base.h>
+#include <wait_queue.h>
 
 #include <cstdarg>
 
@@ -21,6 +22,11 @@
 
 /**
  * Outward-facing scheduler interface - this is meant for use
+ *
+ * Every critical section in the kernel saves the interrupt state on entry and puts it back on exit rather than
+ * enabling interrupts blindly. The same calls are made from tasks, from driver ISRs and from inside other critical
+ * sections (the UART driver waits with interrupts off), and a blind enable would open all of those up. Calls that
+ * switch away (sleep, block, ret, next_period, wait) enable interrupts just long enough for the switch to be taken.
  */
 
 template <scheduling_algorithms alg>
@@ -38,14 +44,16 @@ public:
 	 * Also calls add / remove in the base class
 	 */
 
-	void add_task(const task &t);
+	task *add_task(const task &t);
+	task *add_task(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t priority = 1);
 	void cleanup(const task &t);
 
 	/**
-	 * Initializes operating system using configuration set in config.h
+	 * Initializes operating system using configuration set in config.h - false if the task set fails admission
+	 * or holds more than MAX_TASKS tasks
 	 */
 
-	void init(void);
+	bool init(void);
 
 	/**
 	 * Starts OS once initialized or initializes OS and starts it given a list of tasks
@@ -58,9 +66,11 @@ public:
 	 * Functions handling the context switch process
 	 */
 
-	inline void context_switch(void);
-	inline void save_context(void);
+	inline void context_switch(void *frame);
+	inline void dispatch(void);
+	inline void save_context(void *frame);
 	inline void restore_context(task &runnable);
+	inline void resume_current(void);
 
 #if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
 	inline std::uint32_t enter_kstack(void);
@@ -98,14 +108,51 @@ public:
 	void ret(void);
 
 	/**
-	 * Functions that reawaken tasks or allow scheduler control again
+	 * Ends the current job of a periodic task and sleeps until its next release
+	 */
+
+	void next_period(void);
+
+	/**
+	 * Blocks the current task on a wait queue until it is notified
+	 */
+
+	void wait(wait_queue &queue);
+
+	/**
+	 * Called by an interrupt handler task - returns at once if its vector was raised meanwhile, else blocks until it is.
+	 * Returns the number of interrupts coalesced into the activation.
+	 */
+
+	std::uint16_t wait_interrupt(void);
+
+	/**
+	 * Functions that reawaken tasks or allow scheduler control again - the notifications are safe to call from ISRs
 	 */
 
 
 	void unblock(task &target);
+	void notify_one(wait_queue &queue);
+	void notify_all(wait_queue &queue);
+
+	/**
+	 * Changes the scheduling weight of a task
+	 */
+
+	void set_priority(task &target, std::uint8_t priority);
 
 private:
 	inline void request_preemption(void);
+
+	// Takes a task out of the kernel for good - its TCB, if owned, is queued for reap() rather than freed
+	inline void retire(task &target);
+
+	/**
+	 * System call path for voluntary switches (SYSCALL_TRAP) - the calling task enters the kernel directly instead
+	 * of raising the watchdog interrupt and waiting for preempt()
+	 */
+
+	void trap(void);
 };
 
 #include <scheduler.cpp>
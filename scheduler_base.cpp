@@ -7,6 +7,9 @@
 
 #include <scheduler_base.h>
 #include <scheduler.h>
+#include <watchdog.h>
+#include <pc_sample.h>
+#include <bitops.h>
 
 extern scheduler<scheduling_algorithms::lottery> os;
 
@@ -15,39 +18,340 @@ extern scheduler<scheduling_algorithms::lottery> os;
  */
 
 abstract_scheduler::abstract_scheduler() {
-	this->isr_wait_queue = ring_buffer<isr>(INT_QUEUE_SIZE);
+	for (std::uint8_t &s : this->isr_table) s = no_irq_source;	// Nothing attached
 }
 
 /**
- * Creates an interrupt handler task for the scheduler, mapped to an interrupt or other callback
+ * Creates the handler task of an interrupt vector. The handler is a loop around os.wait_interrupt() - its TCB is
+ * never copied or reallocated afterwards, so servicing an interrupt allocates nothing. Its source is filed after
+ * every source of higher or equal priority. A vector that already has a handler keeps it. With all
+ * MAX_IRQ_SOURCES in use nothing is created and nullptr is returned.
  */
 
-void abstract_scheduler::attach_interrupt(void (*isr)(void), const task &driver_func) {
-	this->isr_vec_table.emplace(std::make_pair(isr, driver_func));
+task *abstract_scheduler::attach_interrupt(std::uint8_t vector, const task &driver_func) {
+	if (this->isr_table[vector] != no_irq_source) return this->isr_sources[this->isr_table[vector]].handler;
+	if (this->num_sources == MAX_IRQ_SOURCES) return nullptr;
+
+	task &handler = this->spawn(driver_func);
+
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	std::uint8_t pos = 0;
+	while (pos < this->num_sources && this->isr_sources[pos].handler->get_priority() >= handler.get_priority()) pos++;
+
+	// Make room - the sources behind move down one slot, and so do their bits
+	for (std::uint8_t s = this->num_sources; s > pos; --s) this->move_source(s - 1, s);
+
+	const std::uint16_t behind = 0xFFFFu >> pos;
+	this->irq_pending = (this->irq_pending & ~behind) | ((this->irq_pending & behind) >> 1);
+	this->irq_running = (this->irq_running & ~behind) | ((this->irq_running & behind) >> 1);
+
+	irq_source &src = this->isr_sources[pos];
+	src = { };
+	src.handler = &handler;
+	src.vector = vector;
+
+	handler.link.source = pos;
+	this->isr_table[vector] = pos;
+	this->irq_running |= irq_bit(pos);	// Runs up to its first wait_interrupt()
+	this->num_sources++;
+
+	_set_interrupt_state(state);
+	return &handler;
+}
+
+/**
+ * Counts a caught interrupt against its source and asks for a switch, so the handler runs as soon as the ISR
+ * returns - unless a handler of equal or higher priority is busy. An interrupt storm only ever bumps the counter,
+ * so no source is lost and the cost stays constant.
+ */
+
+void abstract_scheduler::schedule_interrupt(std::uint8_t vector) {
+	const std::uint8_t s = this->isr_table[vector];
+	if (s == no_irq_source) return;	// Nobody attached
+
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	irq_source &src = this->isr_sources[s];
+	if (src.count < 0xFFFF) src.count++;
+	src.stats.raised++;
+
+	if (!(this->irq_pending & irq_bit(s))) {
+		this->irq_pending |= irq_bit(s);
+#ifdef CPU_ACCOUNTING
+		src.raised_at = cpu_time_now();
+#endif
+	}
+
+	pc_sample_yield();
+	watchdog_request();
+
+	_set_interrupt_state(state);
+}
+
+/**
+ * Returns the figures of an interrupt vector - all zero if nothing is attached to it
+ */
+
+const irq_stats &abstract_scheduler::get_interrupt_stats(std::uint8_t vector) const {
+	static const irq_stats none = { };
+
+	const std::uint8_t s = this->isr_table[vector];
+	return (s == no_irq_source) ? none : this->isr_sources[s].stats;
 }
 
 /**
- * Pushes a caught interrupt on the ISR wait queue for future handling
+ * Accepts any task set - only deadline-driven schedulers have something to check
  */
 
-void abstract_scheduler::schedule_interrupt(void (*isr)(void)) {
-	this->isr_wait_queue.put(isr);	// Simple numeric copy is faster
+bool abstract_scheduler::admit(const task_config *, std::size_t) const {
+	return true;
 }
 
+#ifdef CPU_ACCOUNTING
 /**
- * Handles interrupt decision-making in the scheduler
+ * Takes a consistent snapshot of where the CPU time went - the running task's counter includes its current slice.
+ * The idle hook is not a registered task, its time is in snap.idle.
  */
 
-void abstract_scheduler::service_interrupts(void) {
-	// If any interrupt handlers have completed in some way then remove them
-	while (this->isr_sched_queue.size() > 0 && this->isr_sched_queue.top().blocking()) {
-		this->isr_sched_queue.pop();
+std::size_t abstract_scheduler::cpu_usage(cpu_snapshot &snap, task_usage *tasks, std::size_t max) const {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	const std::uint32_t current = cpu_time_totals(snap);
+
+	std::size_t n = 0;
+	for (const task *t = this->task_list; t != nullptr && n < max; t = t->link.next_task, ++n) {
+		tasks[n].id = t->get_tid();
+		tasks[n].priority = t->get_priority();
+		tasks[n].cycles = t->get_state().cycles + ((t == this->current_process) ? current : 0);
 	}
 
-	while (!this->isr_wait_queue.empty()) {	// If any new interrupts were receieved, push the corresponding tasks to the scheduler queue
-		auto driver_ptr = this->isr_vec_table.find(this->isr_wait_queue.get());	// Find the task corresponding to the ISR just executed
-		this->isr_sched_queue.emplace(driver_ptr->second);	// Push it to the waiting queue
+	snap.count = n;
+
+	_set_interrupt_state(state);
+	return n;
+}
+#endif
+
+/**
+ * Advances kernel time by one tick - only the sleepers at the head of the timer queue are touched
+ */
+
+void abstract_scheduler::tick(void) {
+	this->tick_count++;
+	this->sleepers.tick();
+}
+
+/**
+ * Advances kernel time by a number of ticks that went by unseen - called with interrupts disabled
+ */
+
+void abstract_scheduler::catch_up(std::size_t ticks) {
+	this->tick_count += ticks;
+	this->sleepers.advance(ticks);
+}
+
+/**
+ * Allocates a TCB for a copy of a task that has not run yet and registers it. The TCB stays put until the
+ * task is cleaned up, so references to it remain valid.
+ */
+
+task &abstract_scheduler::spawn(const task &t) {
+	task *tcb = new task(t);
+	tcb->link.owned = true;
+	this->enlist(*tcb);
+	return *tcb;
+}
+
+/**
+ * Constructs a task directly in a fresh TCB and registers it
+ */
+
+task &abstract_scheduler::spawn(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t priority) {
+	task *tcb = new task(runnable, stack_size, priority);
+	tcb->link.owned = true;
+	this->enlist(*tcb);
+	return *tcb;
+}
+
+/**
+ * Pushes a task on the front of the registry
+ */
+
+void abstract_scheduler::enlist(task &t) {
+	if (t.link.enlisted) return;
+
+	t.link.prev_task = nullptr;
+	t.link.next_task = this->task_list;
+	if (this->task_list != nullptr) this->task_list->link.prev_task = &t;
+	this->task_list = &t;
+
+	t.link.enlisted = true;
+	this->num_tasks++;
+}
+
+/**
+ * Unlinks a task from the registry
+ */
+
+void abstract_scheduler::delist(task &t) {
+	if (!t.link.enlisted) return;
+
+	if (t.link.prev_task != nullptr) t.link.prev_task->link.next_task = t.link.next_task;
+	else this->task_list = t.link.next_task;
+	if (t.link.next_task != nullptr) t.link.next_task->link.prev_task = t.link.prev_task;
+
+	t.link.next_task = nullptr;
+	t.link.prev_task = nullptr;
+	t.link.enlisted = false;
+	this->num_tasks--;
+}
+
+/**
+ * Hands a task one of the MAX_TASKS algorithm slots
+ */
+
+bool abstract_scheduler::claim_slot(task &t) {
+	if (t.link.attached) return true;
+	if (this->num_attached >= MAX_TASKS) return false;
+
+	t.link.attached = true;
+	this->num_attached++;
+	return true;
+}
+
+/**
+ * Gives a task's slot back - tasks that never held one are left alone
+ */
+
+void abstract_scheduler::release_slot(task &t) {
+	if (!t.link.attached) return;
+
+	t.link.attached = false;
+	this->num_attached--;
+}
+
+/**
+ * Drops a task that could not be filed - it never ran, so it can go right away
+ */
+
+void abstract_scheduler::discard(task &t) {
+	this->delist(t);
+	if (t.link.owned) delete &t;
+}
+
+/**
+ * Called with interrupts disabled, once the task is out of the registry
+ */
+
+void abstract_scheduler::bury(task &t) {
+	t.link.next_task = this->zombies;
+	this->zombies = &t;
+}
+
+/**
+ * The heap is not reentrant, so TCBs and stacks are only freed here, from a task, one at a time with interrupts
+ * enabled. A task that cleaned itself up still runs on its stack until the next switch, so the current task is
+ * left for a later call - it is the only one that can be.
+ */
+
+void abstract_scheduler::reap(void) {
+	for (;;) {
+		std::uint16_t state = _get_interrupt_state();
+		_disable_interrupt();
+
+		task **link = &this->zombies;
+		if (*link != nullptr && *link == this->current_process) link = &(*link)->link.next_task;
+
+		task *t = *link;
+		if (t != nullptr) *link = t->link.next_task;
+
+		_set_interrupt_state(state);
+
+		if (t == nullptr) return;
+		delete t;
+	}
+}
+
+/**
+ * Handles interrupt decision-making in the scheduler. A source is ready if its handler is busy or has interrupts
+ * waiting for it, and the most urgent ready source is the leading one of the masks. A waiting handler is woken with
+ * everything its source has caught so far. A busy handler that went to sleep or blocked on something other than its
+ * vector keeps its source busy, but is skipped until it wakes up - its interrupts wait for it meanwhile.
+ */
+
+task *abstract_scheduler::next_handler(void) {
+	std::uint16_t ready = this->irq_pending | this->irq_running;
+
+	while (ready != 0) {
+		const std::uint8_t s = clz16(ready);
+		task *handler = this->isr_sources[s].handler;
+
+		if (!(this->irq_running & irq_bit(s))) {
+			this->take_interrupts(s);
+			this->irq_running |= irq_bit(s);
+			handler->unblock();
+			return handler;
+		}
+
+		if (!handler->sleeping() && !handler->blocking()) return handler;
+
+		ready &= ~irq_bit(s);
 	}
+
+	return nullptr;
+}
+
+/**
+ * Turns the interrupts a source has caught into one activation of its handler and closes the latency measurement
+ */
+
+void abstract_scheduler::take_interrupts(std::uint8_t source) {
+	irq_source &src = this->isr_sources[source];
+
+	src.taken = src.count;
+	src.count = 0;
+	this->irq_pending &= ~irq_bit(source);
+
+	irq_stats &stats = src.stats;
+	stats.activations++;
+	if (src.taken > stats.max_coalesced) stats.max_coalesced = src.taken;
+
+#ifdef CPU_ACCOUNTING
+	const std::uint32_t latency = cpu_time_now() - src.raised_at;
+	if (stats.activations == 1 || latency < stats.min_latency) stats.min_latency = latency;
+	if (latency > stats.max_latency) stats.max_latency = latency;
+	stats.total_latency += latency;
+#endif
+}
+
+/**
+ * Removes the source of a handler and closes the gap in the priority order behind it
+ */
+
+void abstract_scheduler::release_handler(task &t) {
+	const std::uint8_t pos = t.link.source;
+	if (pos >= this->num_sources || this->isr_sources[pos].handler != &t) return;
+
+	this->isr_table[this->isr_sources[pos].vector] = no_irq_source;
+	t.link.source = no_irq_source;
+
+	const std::uint16_t behind = 0xFFFFu >> pos;
+	const std::uint16_t moving = behind >> 1;
+	this->irq_pending = (this->irq_pending & ~behind) | ((this->irq_pending & moving) << 1);
+	this->irq_running = (this->irq_running & ~behind) | ((this->irq_running & moving) << 1);
+
+	this->num_sources--;
+	for (std::uint8_t s = pos; s < this->num_sources; ++s) this->move_source(s + 1, s);
+}
+
+void abstract_scheduler::move_source(std::uint8_t from, std::uint8_t to) {
+	this->isr_sources[to] = this->isr_sources[from];
+	this->isr_sources[to].handler->link.source = to;
+	this->isr_table[this->isr_sources[to].vector] = to;
 }
 
 /**
@@ -55,8 +359,6 @@ void abstract_scheduler::service_interrupts(void) {
  */
 
 base_scheduler<scheduling_algorithms::round_robin>::base_scheduler() {
-	this->tasks = std::vector<std::pair<task, std::uint8_t>>();
-	this->current_task_ptr = tasks.begin();
 	this->kstack_ptr = 0x0000;
 }
 
@@ -65,90 +367,120 @@ base_scheduler<scheduling_algorithms::round_robin>::base_scheduler() {
  */
 
 base_scheduler<scheduling_algorithms::lottery>::base_scheduler() {
-	this->tasks = std::vector<task>();
 	this->kstack_ptr = 0x0000;
 }
 
 /**
- * Initializes all of the passed-in tasks, places them in the task list, and sets the start pointer
+ * Initializes all of the passed-in tasks, each in its own stable TCB, and files them for scheduling
  */
 
 base_scheduler<scheduling_algorithms::round_robin>::base_scheduler(const std::initializer_list<task> &task_list) {
-	std::transform (
-		task_list.begin(),
-		task_list.end(),
-		std::back_inserter(this->tasks),
-		[] (const task &t) {
-			return std::make_pair(t, t.get_priority());
-		}
-	);
-
-	this->current_task_ptr = tasks.begin();
+	for (auto it = task_list.begin(); it < task_list.end(); ++it) {
+		task &t = this->spawn(*it);
+		if (!this->attach(t)) this->discard(t);
+	}
 }
 
 /**
- * Initializes all of the passed-in tasks, places them in the task list, and sets the start pointer
+ * Initializes all of the passed-in tasks, each in its own stable TCB, and files them for scheduling
  */
 
 base_scheduler<scheduling_algorithms::lottery>::base_scheduler(const std::initializer_list<task> &task_list) {
-	std::transform (
-		task_list.begin(),
-		task_list.end(),
-		std::back_inserter(this->tasks),
-		[] (const task &t) {
-			return t;
-		}
-	);
+	for (auto it = task_list.begin(); it < task_list.end(); ++it) {
+		task &t = this->spawn(*it);
+		if (!this->attach(t)) this->discard(t);
+	}
 }
 
 /**
- * Adds a task to the list
+ * Files a registered task as asleep or ready according to its state
  */
 
-void base_scheduler<scheduling_algorithms::round_robin>::add_task(const task &t) {
-	this->tasks.emplace_back(std::move(std::make_pair(t, t.get_priority())));
+bool base_scheduler<scheduling_algorithms::round_robin>::attach(task &t) {
+	if (!this->claim_slot(t)) return false;
+	t.link.state = link_state::detached;
+
+	if (t.sleeping()) this->sleepers.insert(t);
+	else this->enqueue(t);
+	return true;
 }
 
 /**
- * Adds a task to the list
+ * Takes a task out of every scheduling structure ahead of its removal
  */
 
-void base_scheduler<scheduling_algorithms::lottery>::add_task(const task &t) {
-	this->tasks.emplace_back(std::move(t));
+void base_scheduler<scheduling_algorithms::round_robin>::detach(task &t) {
+	this->dequeue(t);
+	this->sleepers.remove(t);
+	this->release_slot(t);
 }
 
 /**
- * Deletes a completed task
+ * Files a registered task as asleep or ready according to its state
  */
 
-void base_scheduler<scheduling_algorithms::round_robin>::cleanup(const task &t) {
-	auto it = std::remove_if(
-		this->tasks.begin(),
-		this->tasks.end(),
-		[&](const std::pair<task, std::uint8_t>& element) {
-			return element.first == t;
-		}
-	);
+bool base_scheduler<scheduling_algorithms::lottery>::attach(task &t) {
+	if (!this->claim_slot(t)) return false;
+	if (!this->tickets.attach(t)) {
+		this->release_slot(t);
+		return false;
+	}
+	t.link.state = link_state::detached;
 
-	if (it == this->tasks.end()) return;
-	this->tasks.erase(it);
+	if (t.sleeping()) this->sleepers.insert(t);
+	else this->enqueue(t);
+	return true;
 }
 
 /**
- * Deletes a completed task
+ * Takes a task out of every scheduling structure and releases its ticket slot ahead of its removal
  */
 
-void base_scheduler<scheduling_algorithms::lottery>::cleanup(const task &t) {
-	auto it = std::remove_if(					// Find the task to delete and move it to the end so it can be deleted cleanly
-		this->tasks.begin(),
-		this->tasks.end(),
-		[&](const task& element) {
-			return element == t;
-		}
-	);
+void base_scheduler<scheduling_algorithms::lottery>::detach(task &t) {
+	this->dequeue(t);
+	this->sleepers.remove(t);
+	this->tickets.detach(t);
+	this->release_slot(t);
+}
+
+/**
+ * Puts a task in the ready queue unless it is unable to run
+ */
 
-	if (it == this->tasks.end()) return;		// If it doesn't exist then there is a problem
-	this->tasks.erase(it);						// Else erase the task
+void base_scheduler<scheduling_algorithms::round_robin>::enqueue(task &t) {
+	if (t.sleeping() || t.blocking() || t.complete() || handles_interrupt(t)) return;
+	this->sleepers.remove(t);	// Off the expired chain if it woke up and was made ready before the scheduler took it
+	this->run_queue.push(t);
+}
+
+/**
+ * Takes a task out of the ready queue
+ */
+
+void base_scheduler<scheduling_algorithms::round_robin>::dequeue(task &t) {
+	this->run_queue.remove(t);
+}
+
+/**
+ * Enters a task into the draw with one ticket per priority level
+ */
+
+void base_scheduler<scheduling_algorithms::lottery>::enqueue(task &t) {
+	if (t.sleeping() || t.blocking() || t.complete() || handles_interrupt(t)) return;
+	this->sleepers.remove(t);
+
+	if (this->tickets.set(t, t.get_priority())) t.link.state = link_state::ready;
+}
+
+/**
+ * Withdraws a task's tickets from the draw
+ */
+
+void base_scheduler<scheduling_algorithms::lottery>::dequeue(task &t) {
+	if (t.link.state != link_state::ready) return;
+
+	this->tickets.set(t, 0);
+	t.link.state = link_state::detached;
 }
 
 /**
@@ -156,7 +488,6 @@ void base_scheduler<scheduling_algorithms::lottery>::cleanup(const task &t) {
  */
 
 void base_scheduler<scheduling_algorithms::round_robin>::start(void) {
-	this->current_task_ptr = tasks.begin();
 	this->kstack_ptr = _get_SP_register();
 }
 
@@ -173,75 +504,62 @@ void base_scheduler<scheduling_algorithms::lottery>::start(void) {
  */
 
 task &base_scheduler<scheduling_algorithms::round_robin>::schedule(void) {
-	std::vector<std::pair<task, std::uint8_t>>::iterator &task_ptr = this->current_task_ptr;
-	std::vector<std::pair<task, std::uint8_t>> &tasks = this->tasks;
 
 	/**
-	 * If there are no tasks available, simply idle
+	 * Refresh the resource monitor of the task that was just preempted
 	 */
 
-	std::size_t num_avail = this->num_tasks;
-	if (num_avail == 0) {
-		this->current_process = &task::idle_hook;
-		return task::idle_hook;
+	if (this->current_process != nullptr) {
+		this->current_process->update();
 	}
 
 	/**
-	 * Update the sleep state of every task before considering what can be scheduled
+	 * Wake up any tasks whose sleep ran out
 	 */
 
-	for (auto it = tasks.begin(); it < tasks.end(); ++it) {
-		std::pair<task, std::uint8_t> &proc = *it;
-		task &t = proc.first;
-		t.update();
+	while (task *t = this->sleepers.pop_expired()) {
+		this->enqueue(*t);
 	}
 
 	/**
-	 * Otherwise, iterate sequentially, paying attention to the weights
+	 * Take the head of the highest populated run list. If no tasks are available as a result of
+	 * sleeping / blocking, return the idle hook
 	 */
 
-	for (;;) {
+	task *next = this->run_queue.front();
+	if (next == nullptr) {
+		this->current_process = &task::idle_hook;
+		return task::idle_hook;
+	}
 
-		/**
-		 * For each slot in the list of tasks:
-		 * - Check if it is blocking / sleeping - if so, it is not available
-		 * 	 Also update its sleep counter for this tick
-		 * - Otherwise, check if it still needs to be run
-		 *   If so, decrement the run counter and return the task
-		 *   Otherwise, refresh its run counter and move to the next task
-		 */
-
-		std::pair<task, std::uint8_t> &proc = *task_ptr;
-		task &t = proc.first;
-		const std::size_t run_counts_remaining = proc.second;
-
-		if (!t.sleeping() && !t.blocking()) {
-			if (run_counts_remaining > 0) {
-				proc.second--;
-				break;
-			} else {
-				proc.second = t.get_priority();
-			}
-		} else {
-			num_avail--;
-			proc.second = t.get_priority();
-		}
+	/**
+	 * Charge it a slice - once its weight is spent it sits out the rest of the round
+	 */
 
-		/**
-		 * If no tasks are available as a result of sleeping / blocking, return the idle hook
-		 */
+	if (--next->link.slices == 0) {
+		this->run_queue.expire(*next);
+	}
 
-		if (num_avail == 0) {
-			this->current_process = &task::idle_hook;
-			return task::idle_hook;
-		}
+	this->current_process = next;
+	return *next;
+}
 
-		task_ptr++;
-		if (task_ptr == tasks.end()) task_ptr = tasks.begin();
+/**
+ * schedule() without the decision, for a switch that changes nothing - the running task heads the highest run list
+ * and nobody wakes up, so it would be picked again. Returns false and leaves everything as it was otherwise.
+ */
+
+bool base_scheduler<scheduling_algorithms::round_robin>::keep_current(void) {
+	task *current = this->current_process;
+	if (current == nullptr || !this->quiet_tick() || this->run_queue.front() != current) return false;
+
+	current->update();
+
+	if (--current->link.slices == 0) {
+		this->run_queue.expire(*current);
 	}
 
-	this->current_process = &task_ptr->first;
-	return task_ptr->first;
+	return true;
 }
 
 /**
@@ -321,54 +639,346 @@ std::uint32_t bounded_rand32(std::uint32_t (*rng)(void), std::uint32_t range) {
 task &base_scheduler<scheduling_algorithms::lottery>::schedule(void) {
 
 	/**
-	 * If there are no tasks available, simply idle
+	 * Refresh the resource monitor of the task that was just preempted
 	 */
 
-	std::size_t num_avail = this->num_tasks;
-	if (num_avail == 0) {
+	if (this->current_process != nullptr) {
+		this->current_process->update();
+	}
+
+	/**
+	 * Wake up any tasks whose sleep ran out - their tickets go back into the pool
+	 */
+
+	while (task *t = this->sleepers.pop_expired()) {
+		this->enqueue(*t);
+	}
+
+	const std::uint16_t pool_size = this->tickets.total();
+	if (pool_size == 0) {													// Check if any tasks are eligible
 		this->current_process = &task::idle_hook;
 		return task::idle_hook;
 	}
 
+	const auto roll = bounded_rand32(rand32, pool_size);					// Compute fast random modulus for the draw
+	task *winner = this->tickets.find(static_cast<std::uint16_t>(roll));	// Descend the ticket index to the owner of the roll
+
+	this->current_process = winner;											// We're done here
+	return *winner;
+}
+
+/**
+ * Initializes the scheduler with an empty set of tasks, etc.
+ */
+
+base_scheduler<scheduling_algorithms::stride>::base_scheduler() {
+	this->kstack_ptr = 0x0000;
+}
+
+/**
+ * Initializes all of the passed-in tasks, each in its own stable TCB, and files them for scheduling
+ */
+
+base_scheduler<scheduling_algorithms::stride>::base_scheduler(const std::initializer_list<task> &task_list) {
+	for (auto it = task_list.begin(); it < task_list.end(); ++it) {
+		task &t = this->spawn(*it);
+		if (!this->attach(t)) this->discard(t);
+	}
+}
+
+/**
+ * Files a registered task as asleep or ready according to its state
+ */
+
+bool base_scheduler<scheduling_algorithms::stride>::attach(task &t) {
+	if (!this->claim_slot(t)) return false;
+	t.link.state = link_state::detached;
+	t.link.key = 0;
+
+	if (t.sleeping()) this->sleepers.insert(t);
+	else this->enqueue(t);
+	return true;
+}
+
+/**
+ * Takes a task out of every scheduling structure ahead of its removal
+ */
+
+void base_scheduler<scheduling_algorithms::stride>::detach(task &t) {
+	this->dequeue(t);
+	this->sleepers.remove(t);
+	this->release_slot(t);
+}
+
+/**
+ * Sets the system stack up
+ */
+
+void base_scheduler<scheduling_algorithms::stride>::start(void) {
+	this->kstack_ptr = _get_SP_register();
+}
+
+/**
+ * Puts a task in the pass heap unless it is unable to run. While detached, link.key holds the task's lead over
+ * the virtual time rather than an absolute pass, so a task re-entering after a sleep / block neither catches up
+ * on the time it missed nor loses the credit it had, and wraparound of the pass counter cannot hurt it.
+ */
+
+void base_scheduler<scheduling_algorithms::stride>::enqueue(task &t) {
+	if (t.sleeping() || t.blocking() || t.complete() || handles_interrupt(t)) return;
+	this->sleepers.remove(t);
+	if (t.link.state == link_state::ready) return;
+
+	const std::uint8_t pri = t.get_priority();
+	t.link.stride = static_cast<std::uint16_t>(stride1 / ((pri > 0) ? pri : 1));
+	t.link.key += this->global_pass;
+
+	if (this->pass_heap.push(t)) {
+		t.link.state = link_state::ready;
+	} else {
+		t.link.key -= this->global_pass;	// Cannot happen while claim_slot() caps the tasks at the heap size
+	}
+}
+
+/**
+ * Takes a task out of the pass heap, converting its pass back to a lead over the virtual time
+ */
+
+void base_scheduler<scheduling_algorithms::stride>::dequeue(task &t) {
+	if (t.link.state != link_state::ready) return;
+
+	this->pass_heap.remove(t);
+	t.link.key -= this->global_pass;
+	t.link.state = link_state::detached;
+}
+
+/**
+ * Implements stride scheduling - the task with the smallest pass runs and advances its pass by its stride
+ */
+
+task &base_scheduler<scheduling_algorithms::stride>::schedule(void) {
+
 	/**
-	 * Update the sleep state of every task before considering what can be scheduled
-	 * We're also combining this with a calculation of the intervals since both are O(n)
+	 * Refresh the resource monitor of the task that was just preempted
 	 */
 
-	std::vector<std::uint16_t> intervals;									// Reserve a vector of intervals
-	intervals.reserve(num_avail + 1);
-	intervals.push_back(0);													// Start of the interval list is 0; list generated is [0, sum(valid priorities))
+	if (this->current_process != nullptr) {
+		this->current_process->update();
+	}
 
-	std::uint16_t left = 0;
-	for (auto it = this->tasks.begin(); it < this->tasks.end(); ++it) {		// Loop through, check status and update
-		task &t = *it;
-		t.update();
+	/**
+	 * Wake up any tasks whose sleep ran out
+	 */
 
-		auto pri = t.get_priority();										// If the task is eligible to be scheduled, add the interval
-		if (!t.sleeping() && !t.blocking()) left += pri;
-		intervals.push_back(left);
+	while (task *t = this->sleepers.pop_expired()) {
+		this->enqueue(*t);
 	}
 
-	volatile const auto pool_size = left;
-	if (pool_size == 0) {													// Check if any tasks are eligible
+	/**
+	 * Take the task with the minimum pass. If no tasks are available as a result of sleeping / blocking,
+	 * return the idle hook
+	 */
+
+	task *next = this->pass_heap.top();
+	if (next == nullptr) {
 		this->current_process = &task::idle_hook;
 		return task::idle_hook;
 	}
 
-	const auto roll = bounded_rand32(rand32, pool_size);					// Compute fast random modulus for the draw
-//	const auto roll = std::uint32_t(rand16()) * std::uint32_t(pool_size) >> 16;
-	auto it = std::upper_bound(intervals.begin(), intervals.end(), roll);	// Binary search to find the process
-	volatile auto idx = it - (intervals.begin() + 1);								// Get first element less than or equal to the roll; see std::upper_bound documentation
+	/**
+	 * Its pass becomes the virtual time, then charge it one stride and let it sink
+	 */
+
+	this->global_pass = next->link.key;
+	next->link.key += next->link.stride;
+	this->pass_heap.update(*next);
+
+	this->current_process = next;
+	return *next;
+}
+
+/**
+ * Initializes the scheduler with an empty set of tasks, etc.
+ */
+
+base_scheduler<scheduling_algorithms::edf>::base_scheduler() {
+	this->kstack_ptr = 0x0000;
+}
+
+/**
+ * Initializes all of the passed-in tasks, each in its own stable TCB, and files them for scheduling
+ */
+
+base_scheduler<scheduling_algorithms::edf>::base_scheduler(const std::initializer_list<task> &task_list) {
+	for (auto it = task_list.begin(); it < task_list.end(); ++it) {
+		task &t = this->spawn(*it);
+		if (!this->attach(t)) this->discard(t);
+	}
+}
+
+/**
+ * Files a registered task as asleep or ready according to its state
+ */
+
+bool base_scheduler<scheduling_algorithms::edf>::attach(task &t) {
+	if (!this->claim_slot(t)) return false;
+	t.link.state = link_state::detached;
+
+	if (t.sleeping()) this->sleepers.insert(t);
+	else this->enqueue(t);
+	return true;
+}
+
+/**
+ * Takes a task out of every scheduling structure ahead of its removal
+ */
+
+void base_scheduler<scheduling_algorithms::edf>::detach(task &t) {
+	this->dequeue(t);
+	this->sleepers.remove(t);
+	this->release_slot(t);
+}
+
+/**
+ * Sets the system stack up
+ */
 
-	this->current_process = this->tasks.data() + idx;						// We're done here
-	return this->tasks[idx];
+void base_scheduler<scheduling_algorithms::edf>::start(void) {
+	this->kstack_ptr = _get_SP_register();
+}
+
+/**
+ * Files a periodic job under its absolute deadline, or a background task in the round-robin queue
+ */
+
+void base_scheduler<scheduling_algorithms::edf>::enqueue(task &t) {
+	if (t.sleeping() || t.blocking() || t.complete() || handles_interrupt(t)) return;
+	this->sleepers.remove(t);
+	if (t.link.state == link_state::ready) return;
+
+	if (t.periodic()) {
+		t.link.key = t.absolute_deadline();
+		if (this->edf_heap.push(t)) t.link.state = link_state::ready;
+	} else {
+		this->background.push(t);
+	}
+}
+
+/**
+ * Takes a task out of whichever ready structure holds it
+ */
+
+void base_scheduler<scheduling_algorithms::edf>::dequeue(task &t) {
+	if (t.link.state != link_state::ready) return;
+
+	if (t.periodic()) {
+		this->edf_heap.remove(t);
+		t.link.state = link_state::detached;
+	} else {
+		this->background.remove(t);
+	}
+}
+
+/**
+ * Density test: the set is schedulable under EDF if the sum of wcet / min(deadline, period) does not exceed 1.
+ * Exact for implicit deadlines, sufficient for constrained ones. Computed in 16.16 fixed point.
+ */
+
+bool base_scheduler<scheduling_algorithms::edf>::admit(const task_config *cfgs, std::size_t num_cfgs) const {
+	constexpr std::uint32_t one = 1ul << 16;
+	std::uint32_t utilization = 0;
+
+	for (const task_config *cfg = cfgs; cfg < cfgs + num_cfgs; ++cfg) {
+		if (cfg->period == 0) continue;	// Background tasks only get leftover time
+
+		const std::uint16_t window = (cfg->deadline > 0 && cfg->deadline < cfg->period) ? cfg->deadline : cfg->period;
+		if (cfg->wcet > window) return false;
+
+		utilization += (static_cast<std::uint32_t>(cfg->wcet) << 16) / window;
+		if (utilization > one) return false;
+	}
+
+	return true;
+}
+
+/**
+ * Implements earliest-deadline-first scheduling
+ */
+
+task &base_scheduler<scheduling_algorithms::edf>::schedule(void) {
+
+	/**
+	 * Refresh the resource monitor of the task that was just preempted
+	 */
+
+	if (this->current_process != nullptr) {
+		this->current_process->update();
+	}
+
+	/**
+	 * Release jobs / wake up tasks whose sleep ran out
+	 */
+
+	while (task *t = this->sleepers.pop_expired()) {
+		this->enqueue(*t);
+	}
+
+	/**
+	 * The released job with the earliest deadline always wins
+	 */
+
+	task *next = this->edf_heap.top();
+	if (next != nullptr) {
+		this->current_process = next;
+		return *next;
+	}
+
+	/**
+	 * Otherwise hand the slice to the background tasks, or idle if there are none
+	 */
+
+	next = this->background.front();
+	if (next == nullptr) {
+		this->current_process = &task::idle_hook;
+		return task::idle_hook;
+	}
+
+	if (--next->link.slices == 0) {
+		this->background.expire(*next);
+	}
+
+	this->current_process = next;
+	return *next;
 }
 
 /**
  * Scheduler tick performs a context switch
  */
 
+#ifdef SLICE_TIMER
+#pragma vector = WDT_VECTOR, TIMER0_A0_VECTOR	// Requested switches and slice ends - CCR0 clears its own flag
+#else
 #pragma vector = WDT_VECTOR
+#endif
 __attribute__((naked, interrupt)) void abstract_scheduler::preempt(void) {
-	os.context_switch();
+#if defined(HOST_PORT)
+	preempt_switch(nullptr);	// The host port has parked the interrupted registers already
+#elif defined(__LARGE_CODE_MODEL__)
+	__asm("\tBRA #ctx_preempt");	// Pushes the rest of the frame on the task's stack - never returns
+#else
+	__asm("\tBR #ctx_preempt");
+#endif
+}
+
+extern "C" void preempt_switch(void *frame) {
+	os.context_switch(frame);
+}
+
+/**
+ * System call - the task is saved already and the stack is the kernel's, so only the decision is left
+ */
+
+void abstract_scheduler::syscall(void) {
+	switch_stamp(switch_saved);
+	os.dispatch();
 }
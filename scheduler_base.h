@@ -10,43 +10,172 @@
 
 #include <task.h>
 #include <config.h>
-#include <stable_priority_queue.h>
-#include <ring_buffer.h>
+#include <ready_queue.h>
+#include <sleep_queue.h>
+#include <task_heap.h>
+#include <ticket_index.h>
+#include <cpu_time.h>
 
 #include <cstdlib>
 #include <cstddef>
 
 #include <algorithm>
-#include <vector>
 #include <utility>
 #include <initializer_list>
 #include <queue>
-#include <unordered_map>
 
 /**
- * Base instance of all schedulers - all schedulers share this
+ * Activation and latency figures of an interrupt vector. Interrupts caught while the handler is busy or not yet
+ * dispatched coalesce into one activation. The latency runs from the first of them in schedule_interrupt() to the
+ * activation being handed to the handler, in Timer_A1 cycles - it is only measured with CPU_ACCOUNTING defined.
  */
 
-using isr = void (*)(void);
+struct irq_stats {
+	std::uint16_t raised;			// Interrupts caught
+	std::uint16_t activations;		// Handler activations they were coalesced into
+	std::uint16_t max_coalesced;	// Most interrupts carried by one activation
+	std::uint32_t min_latency;
+	std::uint32_t max_latency;
+	std::uint32_t total_latency;	// Wraps - take differences, as with the CPU time counters
+};
+
+/**
+ * Base instance of all schedulers - all schedulers share this
+ */
 
 class abstract_scheduler {
 public:
 	// Scheduler tick interrupt
 	static __attribute__((interrupt)) void preempt(void);
 
-	void attach_interrupt(void (*isr)(void), const task &driver_func);
-	void schedule_interrupt(void (*isr)(void));
-	void service_interrupts(void);
+	// Kernel side of a system call, entered on the kernel stack through ctx_trap()
+	static void syscall(void);
+
+	// Binds a handler task to an interrupt vector - its TCB and stack are allocated here, once and for good.
+	// nullptr once MAX_IRQ_SOURCES vectors have handlers.
+	task *attach_interrupt(std::uint8_t vector, const task &driver_func);
+
+	// Counts an interrupt against its vector and asks for a switch - called from the driver's ISR
+	void schedule_interrupt(std::uint8_t vector);
+
+	// Activation and latency figures of a vector
+	const irq_stats &get_interrupt_stats(std::uint8_t vector) const;
+
+	// Admission test for a task set - every algorithm except EDF accepts anything
+	bool admit(const task_config *cfgs, std::size_t num_cfgs) const;
+
+	// Ticks elapsed since the scheduler started
+	inline std::uint32_t get_tick_count(void) const;
+
+	// Ticks until the first sleeper is due, 0 if nobody is asleep
+	inline std::size_t get_next_wakeup(void) const;
+
+	// Accounts for ticks that passed with the tick stopped - the woken sleepers are made ready at the next decision
+	void catch_up(std::size_t ticks);
+
+#ifdef CPU_ACCOUNTING
+	// Snapshot of the CPU time totals and of up to max tasks' run times, returns the number of tasks written
+	std::size_t cpu_usage(cpu_snapshot &snap, task_usage *tasks, std::size_t max) const;
+#endif
 
 protected:
 	abstract_scheduler();
 
+	/**
+	 * Interrupt source - a vector with a handler attached. Sources are kept in order of handler priority, highest
+	 * first, and source s owns bit 0x8000 >> s of the masks, so the most urgent one is a single CLZ away.
+	 */
+
+	struct irq_source {
+		task *handler;
+		std::uint8_t vector;
+		std::uint16_t count;		// Interrupts caught and not yet handed over (saturates)
+		std::uint16_t taken;		// Interrupts carried by the handler's current activation
+		std::uint32_t raised_at;	// Timer_A1 cycles at the first of them
+		irq_stats stats;
+	};
+
+	static constexpr std::uint8_t no_irq_source = 0xFF;
+
+	static constexpr std::uint16_t irq_bit(std::uint8_t source) {
+		return static_cast<std::uint16_t>(0x8000u >> source);
+	}
+
+	// Whether a task is the handler of an interrupt source - handlers are run by next_handler(), never filed with
+	// the scheduling algorithm
+	static bool handles_interrupt(const task &t) {
+		return t.link.source != no_irq_source;
+	}
+
+	// Handler to run next, highest priority first - a waiting handler is handed its interrupts here. nullptr if none,
+	// and handlers that sleep or block in the middle of an activation are passed over until they are back.
+	task *next_handler(void);
+
+	// Moves the count of a source into an activation of its handler
+	void take_interrupts(std::uint8_t source);
+
+	// Unbinds a handler from its vector before its TCB goes away - ordinary tasks are left alone
+	void release_handler(task &t);
+
+	// Moves a source to another slot of the priority order, pending state excluded
+	void move_source(std::uint8_t from, std::uint8_t to);
+
+	// Advances kernel time by one tick and counts the sleepers down - only the tick source calls it, never schedule()
+	void tick(void);
+
+	// Counts the job of a periodic task as missed once it is past its deadline and still not done
+	inline void check_deadline(task &t);
+
+	// Whether a switch can leave the running task be as far as every algorithm is concerned - no interrupt to hand
+	// over and no sleeper due
+	inline bool quiet_tick(void) const;
+
+	// Takes the switch in place when the algorithm can tell the running task keeps the CPU - none can by default
+	inline bool keep_current(void) { return false; }
+
+	// Allocates a stable TCB for a task and registers it
+	task &spawn(const task &t);
+	task &spawn(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t priority);
+
+	// Links a task into / out of the task registry in O(1)
+	void enlist(task &t);
+	void delist(task &t);
+
+	// Counts a task against MAX_TASKS as the algorithm files it, false once every slot is taken - the fixed-size
+	// structures (pass heap, ticket index, deadline heap) then never run out
+	bool claim_slot(task &t);
+	void release_slot(task &t);
+
+	// Unregisters and frees a task the algorithm had no slot for
+	void discard(task &t);
+
+	// Queues the TCB of a retired task for reap() - the kernel never frees memory from interrupt context
+	void bury(task &t);
+
+	// Frees the TCBs queued by bury() - task context only
+	void reap(void);
+
+	// Kernel time in ticks
+	std::uint32_t tick_count = 0;
+
+	// The switch in progress came from the watchdog interval, and dispatch() still has to take the tick
+	bool tick_due = false;
+
 	// Pointer to current process
 	task *current_process = nullptr;
 
 	// Number of tasks (avoid divisions & for scheduler information)
 	std::size_t num_tasks = 0;
 
+	// Number of tasks holding an algorithm slot
+	std::size_t num_attached = 0;
+
+	// Head of the intrusive registry of every task - TCBs never move once registered
+	task *task_list = nullptr;
+
+	// Retired TCBs still to be freed, chained through the registry links they no longer need
+	task *zombies = nullptr;
+
 	// Pointer to top of OS-reserved stack
 #if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
 	std::uint32_t kstack_ptr = 0x0000;
@@ -54,16 +183,56 @@ protected:
 	std::uint16_t kstack_ptr = 0x0000;
 #endif
 
-	// Queue of interrupts waiting to be scheduled
-	ring_buffer<isr> isr_wait_queue;
+	// Tasks currently asleep on a timer
+	sleep_queue sleepers;
+
+	// Interrupt to source table, indexed by vector number - no_irq_source where nothing is attached
+	std::uint8_t isr_table[NUM_INTERRUPT_VECTORS];
 
-	// Queue of interrupts scheduled (FIFO with priority sorting)
-	stable_priority_queue<task> isr_sched_queue;
+	// Interrupt sources in priority order
+	irq_source isr_sources[MAX_IRQ_SOURCES];
+	std::uint8_t num_sources = 0;
 
-	// Hash table mapping interrupt to associated task
-	std::unordered_map<isr, task> isr_vec_table;
+	// Sources with interrupts not yet handed to their handler (ISRs set bits, the kernel clears them)
+	volatile std::uint16_t irq_pending = 0;
+
+	// Sources whose handler is in the middle of an activation - these run before any ordinary task
+	std::uint16_t irq_running = 0;
 };
 
+/**
+ * Returns the kernel time in ticks
+ */
+
+inline std::uint32_t abstract_scheduler::get_tick_count(void) const {
+	return this->tick_count;
+}
+
+/**
+ * Returns the number of ticks the kernel could go without a tick and miss nothing
+ */
+
+inline std::size_t abstract_scheduler::get_next_wakeup(void) const {
+	return this->sleepers.next_expiry();
+}
+
+/**
+ * Tells whether the decision at hand wakes nobody and finds no interrupt to hand over - the tick, if this switch
+ * is one, has been taken already
+ */
+
+inline bool abstract_scheduler::quiet_tick(void) const {
+	return (this->irq_pending | this->irq_running) == 0 && !this->sleepers.has_expired();
+}
+
+/**
+ * A job is past its deadline from the tick after it - task::miss_deadline() counts each job once
+ */
+
+inline void abstract_scheduler::check_deadline(task &t) {
+	if (t.periodic() && static_cast<std::int32_t>(this->tick_count - t.absolute_deadline()) > 0) t.miss_deadline();
+}
+
 /**
  * Specialization of abstract scheduler with compile-time member variable selection depending on
  * template argument (selection of scheduling algorithm)
@@ -87,9 +256,9 @@ public:
 	base_scheduler(const std::initializer_list<task> &task_list);
 
 
-	// Adds / removes task to / from process queue
-	void add_task(const task &t);
-	void cleanup(const task &t);
+	// Files a registered task in / removes it from the scheduling structures - false if MAX_TASKS are filed already
+	bool attach(task &t);
+	void detach(task &t);
 
 	// Starts OS up once initialized correctly
 	void start(void);
@@ -97,10 +266,16 @@ public:
 	// Schedules a process
 	task &schedule(void);
 
-public:
-	// List of tasks and pointer to current task & associated run counter in list
-	std::vector<std::pair<task, std::uint8_t>> tasks;
-	std::vector<std::pair<task, std::uint8_t>>::iterator current_task_ptr;
+	// Charges the running task its next slice when schedule() is certain to pick it again
+	bool keep_current(void);
+
+	// Moves a task into / out of the ready queue when it wakes up / sleeps, blocks or exits
+	void enqueue(task &t);
+	void dequeue(task &t);
+
+private:
+	// Runnable tasks, bucketed by priority
+	ready_queue run_queue;
 };
 
 /**
@@ -119,9 +294,9 @@ public:
 	base_scheduler(const std::initializer_list<task> &task_list);
 
 
-	// Adds / removes task to / from process queue
-	void add_task(const task &t);
-	void cleanup(const task &t);
+	// Files a registered task in / removes it from the scheduling structures - false if MAX_TASKS are filed already
+	bool attach(task &t);
+	void detach(task &t);
 
 	// Starts OS up once initialized correctly
 	void start(void);
@@ -129,11 +304,125 @@ public:
 	// Schedules a process
 	task &schedule(void);
 
+	// Moves a task into / out of the ticket pool when it wakes up / sleeps, blocks or exits
+	void enqueue(task &t);
+	void dequeue(task &t);
+
 private:
 
-	// List of tasks
-	std::vector<task> tasks;
+	// Tickets held by each runnable task
+	ticket_index tickets;
+};
+
+/**
+ * Stride scheduler implementation of scheduler - deterministic proportional share
+ */
+
+template <>
+class base_scheduler<scheduling_algorithms::stride> : public abstract_scheduler {
+public:
+
+	/**
+	 * Constructors to initialize member variables using an initializer list of tasks, etc.
+	 */
+
+	base_scheduler();
+	base_scheduler(const std::initializer_list<task> &task_list);
+
+
+	// Files a registered task in / removes it from the scheduling structures - false if MAX_TASKS are filed already
+	bool attach(task &t);
+	void detach(task &t);
+
+	// Starts OS up once initialized correctly
+	void start(void);
+
+	// Schedules a process
+	task &schedule(void);
+
+	// Moves a task into / out of the pass heap when it wakes up / sleeps, blocks or exits
+	void enqueue(task &t);
+	void dequeue(task &t);
+
+	/**
+	 * Fixed-point numerator of the stride - a task's stride is stride1 / priority
+	 */
+
+	static constexpr std::uint32_t stride1 = 1ul << 15;
+
+private:
+
+	/**
+	 * Heap ordering on pass values, tolerant of 32-bit wraparound
+	 */
+
+	struct pass_order {
+		inline bool operator()(const task *t1, const task *t2) const {
+			return static_cast<std::int32_t>(t1->link.key - t2->link.key) < 0;
+		}
+	};
+
+	// Runnable tasks ordered by pass value
+	task_heap<pass_order, MAX_TASKS> pass_heap;
+
+	// Pass value of the most recently dispatched task - the scheduler's virtual time
+	std::uint32_t global_pass = 0;
+};
+
+/**
+ * Earliest-deadline-first scheduler implementation - periodic tasks are dispatched by absolute deadline,
+ * background tasks (period 0) share the leftover time in weighted round-robin order
+ */
+
+template <>
+class base_scheduler<scheduling_algorithms::edf> : public abstract_scheduler {
+public:
+
+	/**
+	 * Constructors to initialize member variables using an initializer list of tasks, etc.
+	 */
+
+	base_scheduler();
+	base_scheduler(const std::initializer_list<task> &task_list);
+
+
+	// Files a registered task in / removes it from the scheduling structures - false if MAX_TASKS are filed already
+	bool attach(task &t);
+	void detach(task &t);
+
+	// Starts OS up once initialized correctly
+	void start(void);
+
+	// Schedules a process
+	task &schedule(void);
+
+	// Moves a task into / out of the deadline heap or background queue
+	void enqueue(task &t);
+	void dequeue(task &t);
+
+	// Utilization-based admission test for a set of periodic tasks
+	bool admit(const task_config *cfgs, std::size_t num_cfgs) const;
+
+private:
+
+	/**
+	 * Heap ordering on absolute deadlines, tolerant of 32-bit wraparound
+	 */
+
+	struct deadline_order {
+		inline bool operator()(const task *t1, const task *t2) const {
+			return static_cast<std::int32_t>(t1->link.key - t2->link.key) < 0;
+		}
+	};
+
+	// Released periodic jobs ordered by absolute deadline
+	task_heap<deadline_order, MAX_TASKS> edf_heap;
+
+	// Runnable background tasks
+	ready_queue background;
 };
 
+// C entry of the scheduler tick, called by ctx_preempt() with the address of the interrupted task's frame
+extern "C" void preempt_switch(void *frame);
 
 #endif /* SCHEDULER_BASE_H_ */
@@ -0,0 +1,646 @@
+/*
+ * sched_sim.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <scheduler.h>
+#include <wait_queue.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+
+/**
+ * Offline scheduling simulator, built on the host port (see the README). A workload trace is replayed tick by tick
+ * through schedule() of every algorithm - the real base_scheduler specializations, but no context switches - and
+ * each policy is scored on wake-up latency, fairness against the priority weights, starvation and decision cost.
+ *
+ *     sched_sim [--json] [--ticks N] trace-file
+ *     sched_sim [--json] [--ticks N] --synthetic tasks seed [--dump]
+ *
+ * A trace holds one event per line, '#' starts a comment:
+ *
+ *     <tick> task <name> [prio=N] [period=N] [wcet=N] [deadline=N] [program="..."]
+ *     <tick> unblock <name>                      - wakes a task that ran "block"
+ *     <tick> isr <queue> [every=N] [count=N]     - notify_one() on a wait queue, optionally repeating
+ *     <tick> end                                 - end of the simulation
+ *
+ * A task loops over its program for as long as it lives, one instruction after the other:
+ *
+ *     run N     - needs N ticks of CPU
+ *     sleep N   - sleeps for N ticks
+ *     wait Q    - blocks on wait queue Q until an isr event notifies it
+ *     block     - blocks until an unblock event
+ *     period    - ends the current job and sleeps until the next release (EDF)
+ *     exit      - completes the task
+ *
+ * The default program is "run 1", a task that never gives the CPU up. Calls are made at the end of the tick the
+ * task spends on its last run instruction, or in a tick of their own if nothing runs before them.
+ */
+
+/**
+ * Trace representation
+ */
+
+enum class op : std::uint8_t { run, sleep, wait, block, period, exit };
+
+struct instruction {
+	op code;
+	std::uint32_t arg;
+	std::string queue;
+};
+
+struct task_spec {
+	std::string name;
+	std::uint8_t priority;
+	std::uint16_t period;
+	std::uint16_t wcet;
+	std::uint16_t deadline;
+	std::vector<instruction> program;
+};
+
+enum class event_kind : std::uint8_t { arrive, unblock, isr };
+
+struct event {
+	std::uint32_t tick;
+	event_kind kind;
+	std::size_t spec;		// arrive
+	std::string target;		// unblock (task) / isr (queue)
+	std::uint32_t every;	// isr
+	std::uint32_t count;	// isr
+};
+
+struct trace {
+	std::vector<task_spec> specs;
+	std::vector<event> events;
+	std::uint32_t end = 0;
+};
+
+/**
+ * Parser
+ */
+
+static std::vector<std::string> tokenize(const std::string &line) {
+	std::vector<std::string> tokens;
+	std::string cur;
+	bool quoted = false;
+
+	for (char c : line) {
+		if (c == '"') quoted = !quoted;
+		else if ((c == ' ' || c == '\t') && !quoted) {
+			if (!cur.empty()) tokens.push_back(cur);
+			cur.clear();
+		} else {
+			cur += c;
+		}
+	}
+
+	if (!cur.empty()) tokens.push_back(cur);
+	return tokens;
+}
+
+static bool parse_program(const std::string &text, std::vector<instruction> &program) {
+	std::stringstream ss(text);
+	std::string item;
+
+	while (std::getline(ss, item, ';')) {
+		std::stringstream words(item);
+		std::string name, arg;
+		if (!(words >> name)) continue;
+		words >> arg;
+
+		instruction in = { op::run, 0, "" };
+		if (name == "run" || name == "sleep") {
+			in.code = (name == "run") ? op::run : op::sleep;
+			in.arg = std::strtoul(arg.c_str(), nullptr, 10);
+			if (in.code == op::run && in.arg == 0) return false;
+		} else if (name == "wait" && !arg.empty()) {
+			in.code = op::wait;
+			in.queue = arg;
+		} else if (name == "block") {
+			in.code = op::block;
+		} else if (name == "period") {
+			in.code = op::period;
+		} else if (name == "exit") {
+			in.code = op::exit;
+		} else {
+			return false;
+		}
+
+		program.push_back(in);
+	}
+
+	return true;
+}
+
+static bool parse_trace(std::istream &in, trace &out, std::string &error) {
+	std::string line;
+	std::size_t number = 0;
+
+	while (std::getline(in, line)) {
+		++number;
+		line = line.substr(0, line.find('#'));
+
+		const std::vector<std::string> tokens = tokenize(line);
+		if (tokens.empty()) continue;
+
+		if (tokens.size() < 2) {
+			error = "line " + std::to_string(number) + ": expected <tick> <event>";
+			return false;
+		}
+
+		event ev = { static_cast<std::uint32_t>(std::strtoul(tokens[0].c_str(), nullptr, 10)), event_kind::arrive, 0, "", 0, 1 };
+		const std::string &kind = tokens[1];
+
+		std::map<std::string, std::string> args;
+		for (std::size_t i = 3; i < tokens.size(); ++i) {
+			const std::size_t eq = tokens[i].find('=');
+			if (eq == std::string::npos) {
+				error = "line " + std::to_string(number) + ": expected key=value, got " + tokens[i];
+				return false;
+			}
+			args[tokens[i].substr(0, eq)] = tokens[i].substr(eq + 1);
+		}
+
+		auto number_arg = [&](const char *key, unsigned long fallback) {
+			return args.count(key) ? std::strtoul(args[key].c_str(), nullptr, 10) : fallback;
+		};
+
+		if (kind == "end") {
+			out.end = ev.tick;
+			continue;
+		}
+
+		if (tokens.size() < 3) {
+			error = "line " + std::to_string(number) + ": " + kind + " needs a name";
+			return false;
+		}
+
+		if (kind == "task") {
+			task_spec spec = { tokens[2], static_cast<std::uint8_t>(number_arg("prio", 1)),
+				static_cast<std::uint16_t>(number_arg("period", 0)), static_cast<std::uint16_t>(number_arg("wcet", 0)),
+				static_cast<std::uint16_t>(number_arg("deadline", 0)), { } };
+
+			if (!parse_program(args.count("program") ? args["program"] : "run 1", spec.program) || spec.program.empty()) {
+				error = "line " + std::to_string(number) + ": bad program for " + spec.name;
+				return false;
+			}
+
+			ev.kind = event_kind::arrive;
+			ev.spec = out.specs.size();
+			out.specs.push_back(spec);
+		} else if (kind == "unblock") {
+			ev.kind = event_kind::unblock;
+			ev.target = tokens[2];
+		} else if (kind == "isr") {
+			ev.kind = event_kind::isr;
+			ev.target = tokens[2];
+			ev.every = number_arg("every", 0);
+			ev.count = number_arg("count", ev.every ? ~0ul : 1);
+		} else {
+			error = "line " + std::to_string(number) + ": unknown event " + kind;
+			return false;
+		}
+
+		out.events.push_back(ev);
+	}
+
+	std::stable_sort(out.events.begin(), out.events.end(), [](const event &a, const event &b) { return a.tick < b.tick; });
+	return true;
+}
+
+/**
+ * Random workload - a mix of CPU-bound tasks, sleepers and interrupt-driven handlers at assorted priorities
+ */
+
+static std::string synthetic_trace(std::size_t tasks, unsigned seed) {
+	std::mt19937 rng(seed);
+	auto pick = [&](std::uint32_t lo, std::uint32_t hi) { return std::uniform_int_distribution<std::uint32_t>(lo, hi)(rng); };
+
+	std::ostringstream out;
+	out << "# synthetic workload: " << tasks << " tasks, seed " << seed << "\n";
+
+	for (std::size_t i = 0; i < tasks; ++i) {
+		const std::uint32_t arrival = pick(0, 50);
+		const std::uint32_t prio = pick(1, 8);
+
+		switch (pick(0, 3)) {
+			case 0:
+				out << arrival << " task cpu" << i << " prio=" << prio << "\n";
+				break;
+			case 1:
+				out << arrival << " task sleeper" << i << " prio=" << prio << " program=\"run " << pick(1, 4)
+					<< "; sleep " << pick(2, 40) << "\"\n";
+				break;
+			case 2:
+				out << arrival << " task handler" << i << " prio=" << prio << " program=\"wait q" << i << "; run "
+					<< pick(1, 3) << "\"\n";
+				out << arrival << " isr q" << i << " every=" << pick(5, 30) << "\n";
+				break;
+			case 3:
+				out << arrival << " task batch" << i << " prio=" << prio << " program=\"run " << pick(50, 400)
+					<< "; exit\"\n";
+				break;
+		}
+	}
+
+	return out.str();
+}
+
+/**
+ * Per-policy replay
+ */
+
+struct sim_task {
+	const task_spec *spec;
+	task *tcb;
+	std::size_t pc = 0;				// Current instruction
+	std::uint32_t left = 0;			// Ticks left on the current run instruction
+	bool manual_block = false;		// Blocked through "block" - the only kind an unblock event may wake
+	bool alive = true;
+
+	bool was_runnable = false;
+	std::int64_t ready_since = -1;	// Tick it has been waiting for the CPU since, -1 while running or off the ready set
+	bool woke = false;				// The wait started with a wake-up (arrival, sleep ending, unblock, notification)
+
+	std::uint64_t runs = 0;
+	double expected = 0;			// Ticks it would have had with every runnable task served by weight
+	std::uint32_t longest_wait = 0;
+	std::vector<std::uint32_t> latencies;
+};
+
+struct policy_result {
+	const char *name;
+	std::uint32_t ticks;
+	std::uint64_t idle;
+	std::vector<std::uint32_t> decision_ns;
+	std::vector<std::unique_ptr<sim_task>> tasks;
+};
+
+static std::int16_t spin(void) {
+	for (;;);
+	return 0;
+}
+
+template <class T>
+static T percentile(std::vector<T> samples, unsigned p) {
+	if (samples.empty()) return 0;
+	std::sort(samples.begin(), samples.end());
+	return samples[(samples.size() - 1) * p / 100];
+}
+
+using sim_clock = std::chrono::steady_clock;
+
+template <scheduling_algorithms alg>
+static void replay(const trace &tr, std::uint32_t ticks, policy_result &result) {
+	auto *s = new scheduler<alg>();
+	std::map<std::string, wait_queue> queues;
+	std::map<const task *, sim_task *> by_tcb;
+	std::map<std::string, sim_task *> by_name;
+
+	struct repeat { std::uint32_t next; std::uint32_t every; std::uint32_t left; std::string queue; };
+	std::vector<repeat> interrupts;
+
+	result.ticks = ticks;
+	result.idle = 0;
+	result.decision_ns.reserve(ticks);
+
+	sim_task *retiring = nullptr;
+	std::size_t next_event = 0;
+
+	for (std::uint32_t tick = 0; tick < ticks; ++tick) {
+		// A task that exited on the last tick is retired ahead of the next decision, as context_switch() does
+		if (retiring != nullptr) {
+			by_tcb.erase(retiring->tcb);
+			s->cleanup(*retiring->tcb);
+			retiring->tcb = nullptr;
+			retiring->alive = false;
+			retiring = nullptr;
+		}
+
+		for (; next_event < tr.events.size() && tr.events[next_event].tick <= tick; ++next_event) {
+			const event &ev = tr.events[next_event];
+
+			switch (ev.kind) {
+				case event_kind::arrive: {
+					const task_spec &spec = tr.specs[ev.spec];
+					task proto(spin, 32, spec.priority);
+					proto.set_timing(spec.period, spec.wcet, spec.deadline);
+					proto.release(tick);
+
+					std::unique_ptr<sim_task> st(new sim_task());
+					st->spec = &spec;
+					st->tcb = s->add_task(proto);	// At most MAX_TASKS specs, checked up front
+					by_tcb[st->tcb] = st.get();
+					by_name[spec.name] = st.get();
+					result.tasks.push_back(std::move(st));
+					break;
+				}
+
+				case event_kind::unblock: {
+					auto it = by_name.find(ev.target);
+					if (it != by_name.end() && it->second->alive && it->second->manual_block) {
+						it->second->manual_block = false;
+						s->unblock(*it->second->tcb);
+					}
+					break;
+				}
+
+				case event_kind::isr:
+					interrupts.push_back({ ev.tick, ev.every, ev.count, ev.target });
+					break;
+			}
+		}
+
+		for (repeat &irq : interrupts) {
+			if (irq.left == 0 || irq.next != tick) continue;
+
+			s->notify_one(queues[irq.queue]);
+			--irq.left;
+			irq.next += irq.every ? irq.every : 0;
+			if (irq.every == 0) irq.left = 0;
+		}
+
+		/**
+		 * The decision itself - the only part that is timed
+		 */
+
+		const auto start = sim_clock::now();
+		s->catch_up(1);	// The tick that leads to the decision
+		task &next = s->schedule();
+		const auto stop = sim_clock::now();
+		result.decision_ns.push_back(static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()));
+
+		/**
+		 * Who could have run this tick, and what each would have been owed by weight
+		 */
+
+		std::uint32_t weights = 0;
+		for (auto &st : result.tasks) {
+			if (!st->alive) continue;
+
+			const task &t = *st->tcb;
+			const bool runnable = !t.sleeping() && !t.blocking() && !t.complete();
+
+			if (runnable && !st->was_runnable) {
+				st->ready_since = tick;
+				st->woke = true;
+			} else if (runnable && st->ready_since < 0) {
+				st->ready_since = tick;		// Preempted while it still wanted the CPU
+				st->woke = false;
+			}
+
+			if (runnable) weights += t.get_priority();
+		}
+
+		for (auto &st : result.tasks) {
+			if (!st->alive) continue;
+
+			const task &t = *st->tcb;
+			if (!t.sleeping() && !t.blocking() && !t.complete() && weights > 0) {
+				st->expected += static_cast<double>(t.get_priority()) / weights;
+			}
+		}
+
+		if (&next == &task::idle_hook) {
+			++result.idle;
+		} else {
+			sim_task &st = *by_tcb[&next];
+			const std::uint32_t waited = static_cast<std::uint32_t>(tick - st.ready_since);
+
+			if (st.woke) st.latencies.push_back(waited);
+			st.longest_wait = std::max(st.longest_wait, waited);
+			st.ready_since = -1;
+			st.woke = false;
+			st.runs++;
+
+			/**
+			 * Run its program - a task has to be running to make a call
+			 */
+
+			const std::vector<instruction> &program = st.spec->program;
+			bool ran = false;
+
+			for (std::size_t steps = 0; steps <= program.size(); ++steps) {
+				const instruction &in = program[st.pc];
+
+				if (in.code == op::run) {
+					if (ran) break;
+					if (st.left == 0) st.left = in.arg;
+					ran = true;
+					if (--st.left > 0) break;
+
+					st.pc = (st.pc + 1) % program.size();
+					continue;
+				}
+
+				st.pc = (st.pc + 1) % program.size();
+
+				bool yielded = true;
+				switch (in.code) {
+					case op::sleep: s->sleep(in.arg); yielded = (in.arg > 0); break;
+					case op::wait: s->wait(queues[in.queue]); break;
+					case op::block: st.manual_block = true; s->block(); break;
+					case op::period: s->next_period(); yielded = next.sleeping(); break;
+					case op::exit: s->ret(); retiring = &st; break;
+					case op::run: break;
+				}
+
+				if (yielded) break;
+			}
+		}
+
+		for (auto &st : result.tasks) {
+			if (!st->alive) continue;
+
+			const task &t = *st->tcb;
+			st->was_runnable = !t.sleeping() && !t.blocking() && !t.complete();
+		}
+	}
+
+	// Tasks still waiting at the end count towards the longest wait
+	for (auto &st : result.tasks) {
+		if (st->alive && st->ready_since >= 0) {
+			st->longest_wait = std::max(st->longest_wait, static_cast<std::uint32_t>(ticks - st->ready_since));
+		}
+	}
+
+	for (auto &st : result.tasks) {
+		if (st->alive) s->cleanup(*st->tcb);
+	}
+
+	delete s;
+}
+
+/**
+ * Reports
+ */
+
+static double jain_index(const policy_result &r) {
+	double sum = 0, squares = 0;
+	std::size_t n = 0;
+
+	for (const auto &st : r.tasks) {
+		if (st->expected < 10) continue;	// Too little contention to say anything
+
+		const double x = st->runs / st->expected;
+		sum += x;
+		squares += x * x;
+		++n;
+	}
+
+	return (n > 0 && squares > 0) ? (sum * sum) / (n * squares) : 1.0;
+}
+
+static void report_text(const policy_result &r) {
+	std::vector<std::uint32_t> latencies;
+	std::uint32_t longest = 0;
+	for (const auto &st : r.tasks) {
+		latencies.insert(latencies.end(), st->latencies.begin(), st->latencies.end());
+		longest = std::max(longest, st->longest_wait);
+	}
+
+	std::uint64_t total_ns = 0;
+	for (std::uint32_t ns : r.decision_ns) total_ns += ns;
+
+	std::printf("%s: %u ticks, idle %.1f%%, fairness (Jain) %.3f, longest wait %u ticks\n", r.name, r.ticks,
+			100.0 * r.idle / r.ticks, jain_index(r), longest);
+	std::printf("  wake-up latency (ticks): p50 %u p90 %u p99 %u max %u\n", percentile(latencies, 50),
+			percentile(latencies, 90), percentile(latencies, 99), percentile(latencies, 100));
+	std::printf("  decision cost (ns): mean %.0f p99 %u max %u\n", static_cast<double>(total_ns) / r.decision_ns.size(),
+			percentile(r.decision_ns, 99), percentile(r.decision_ns, 100));
+
+	std::printf("  %-14s %4s %8s %8s %6s %8s %8s %8s %8s\n", "task", "prio", "share", "owed", "ratio", "lat p50",
+			"lat p99", "lat max", "longest");
+
+	for (const auto &st : r.tasks) {
+		std::printf("  %-14s %4u %7.1f%% %7.1f%% %6.2f %8u %8u %8u %8u\n", st->spec->name.c_str(), st->spec->priority,
+				100.0 * st->runs / r.ticks, 100.0 * st->expected / r.ticks,
+				(st->expected > 0) ? st->runs / st->expected : 0.0, percentile(st->latencies, 50),
+				percentile(st->latencies, 99), percentile(st->latencies, 100), st->longest_wait);
+	}
+
+	std::printf("\n");
+}
+
+static void report_json(const policy_result &r) {
+	std::vector<std::uint32_t> latencies;
+	std::uint32_t longest = 0;
+	for (const auto &st : r.tasks) {
+		latencies.insert(latencies.end(), st->latencies.begin(), st->latencies.end());
+		longest = std::max(longest, st->longest_wait);
+	}
+
+	std::uint64_t total_ns = 0;
+	for (std::uint32_t ns : r.decision_ns) total_ns += ns;
+
+	std::printf("{\"policy\": \"%s\", \"ticks\": %u, \"idle_share\": %.4f, \"jain\": %.4f, \"longest_wait\": %u, "
+			"\"latency_p50\": %u, \"latency_p90\": %u, \"latency_p99\": %u, \"latency_max\": %u, "
+			"\"decision_ns_mean\": %.1f, \"decision_ns_p99\": %u, \"decision_ns_max\": %u}\n",
+			r.name, r.ticks, static_cast<double>(r.idle) / r.ticks, jain_index(r), longest,
+			percentile(latencies, 50), percentile(latencies, 90), percentile(latencies, 99), percentile(latencies, 100),
+			static_cast<double>(total_ns) / r.decision_ns.size(), percentile(r.decision_ns, 99),
+			percentile(r.decision_ns, 100));
+
+	for (const auto &st : r.tasks) {
+		std::printf("{\"policy\": \"%s\", \"task\": \"%s\", \"priority\": %u, \"runs\": %llu, \"owed\": %.1f, "
+				"\"latency_p50\": %u, \"latency_p99\": %u, \"latency_max\": %u, \"longest_wait\": %u}\n",
+				r.name, st->spec->name.c_str(), st->spec->priority, static_cast<unsigned long long>(st->runs),
+				st->expected, percentile(st->latencies, 50), percentile(st->latencies, 99),
+				percentile(st->latencies, 100), st->longest_wait);
+	}
+}
+
+template <scheduling_algorithms alg>
+static void simulate(const char *name, const trace &tr, std::uint32_t ticks, bool json) {
+	policy_result result;
+	result.name = name;
+
+	replay<alg>(tr, ticks, result);
+
+	if (json) report_json(result);
+	else report_text(result);
+}
+
+int main(int argc, char **argv) {
+	bool json = false, dump = false;
+	std::uint32_t ticks = 0;
+	std::string source;
+	std::string text;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!std::strcmp(argv[i], "--json")) json = true;
+		else if (!std::strcmp(argv[i], "--dump")) dump = true;
+		else if (!std::strcmp(argv[i], "--ticks") && i + 1 < argc) ticks = std::strtoul(argv[++i], nullptr, 10);
+		else if (!std::strcmp(argv[i], "--synthetic") && i + 2 < argc) {
+			text = synthetic_trace(std::strtoul(argv[i + 1], nullptr, 10), std::strtoul(argv[i + 2], nullptr, 10));
+			source = "synthetic";
+			i += 2;
+		} else source = argv[i];
+	}
+
+	if (source.empty()) {
+		std::fprintf(stderr, "usage: %s [--json] [--ticks N] trace-file | --synthetic tasks seed [--dump]\n", argv[0]);
+		return 1;
+	}
+
+	if (dump) {
+		std::fputs(text.c_str(), stdout);
+		return 0;
+	}
+
+	trace tr;
+	std::string error;
+
+	bool parsed;
+	if (text.empty()) {
+		std::ifstream file(source);
+		if (!file) {
+			std::fprintf(stderr, "%s: cannot open %s\n", argv[0], source.c_str());
+			return 1;
+		}
+		parsed = parse_trace(file, tr, error);
+	} else {
+		std::istringstream in(text);
+		parsed = parse_trace(in, tr, error);
+	}
+
+	if (!parsed) {
+		std::fprintf(stderr, "%s: %s: %s\n", argv[0], source.c_str(), error.c_str());
+		return 1;
+	}
+
+	if (tr.specs.size() > MAX_TASKS) {
+		std::fprintf(stderr, "%s: %zu tasks, the kernel is built for %u (raise MAX_TASKS)\n", argv[0], tr.specs.size(),
+				static_cast<unsigned>(MAX_TASKS));
+		return 1;
+	}
+
+	if (ticks == 0) ticks = tr.end ? tr.end : 10000;
+
+	// schedule() is called directly - the watchdog tick has nothing to do here
+	struct itimerval stop = { };
+	setitimer(ITIMER_REAL, &stop, nullptr);
+
+	simulate<scheduling_algorithms::round_robin>("round_robin", tr, ticks, json);
+	simulate<scheduling_algorithms::lottery>("lottery", tr, ticks, json);
+	simulate<scheduling_algorithms::stride>("stride", tr, ticks, json);
+	simulate<scheduling_algorithms::edf>("edf", tr, ticks, json);
+
+	return 0;
+}
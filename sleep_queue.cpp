@@ -0,0 +1,152 @@
+/*
+ * sleep_queue.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <sleep_queue.h>
+
+/**
+ * Default constructor
+ */
+
+sleep_queue::sleep_queue() {
+	this->clear();
+}
+
+/**
+ * Drops every sleeper
+ */
+
+void sleep_queue::clear(void) {
+	this->head = nullptr;
+	this->expired = nullptr;
+}
+
+/**
+ * Walks down the list consuming the deltas of the sleepers that wake up no later than this task, then splices
+ * it in and takes its share out of the delta of the sleeper behind it
+ */
+
+void sleep_queue::insert(task &t) {
+	if (t.link.state == link_state::sleeping) return;
+	this->remove(t);
+
+	std::size_t remaining = t.get_state().sleep_ticks;
+	task *prev = nullptr;
+	task *it = this->head;
+
+	while (it != nullptr && it->link.delta <= remaining) {
+		remaining -= it->link.delta;
+		prev = it;
+		it = it->link.next;
+	}
+
+	t.link.delta = remaining;
+	t.link.prev = prev;
+	t.link.next = it;
+	t.link.state = link_state::sleeping;
+
+	if (prev != nullptr) prev->link.next = &t;
+	else this->head = &t;
+
+	if (it != nullptr) {
+		it->link.prev = &t;
+		it->link.delta -= remaining;
+	}
+}
+
+/**
+ * Unlinks a task from the sleep list, handing its delta on to the sleeper behind it, or from the expired chain
+ */
+
+void sleep_queue::remove(task &t) {
+	if (t.link.state == link_state::expired) {
+		this->unchain(t);
+		return;
+	}
+
+	if (t.link.state != link_state::sleeping) return;
+
+	if (t.link.prev != nullptr) t.link.prev->link.next = t.link.next;
+	else this->head = t.link.next;
+
+	if (t.link.next != nullptr) {
+		t.link.next->link.prev = t.link.prev;
+		t.link.next->link.delta += t.link.delta;
+	}
+
+	t.link.next = nullptr;
+	t.link.prev = nullptr;
+	t.link.delta = 0;
+	t.link.state = link_state::detached;
+}
+
+/**
+ * Counts the head down by one tick and moves every sleeper that is now due onto the expired chain
+ */
+
+void sleep_queue::tick(void) {
+	if (this->head == nullptr) return;
+	if (this->head->link.delta > 0) this->head->link.delta--;
+
+	this->collect();
+}
+
+/**
+ * Consumes the deltas down the list until the ticks run out - every sleeper whose delta is used up expires
+ */
+
+void sleep_queue::advance(std::size_t ticks) {
+	while (this->head != nullptr && ticks > 0) {
+		if (this->head->link.delta > ticks) {
+			this->head->link.delta -= ticks;
+			return;
+		}
+
+		ticks -= this->head->link.delta;
+		this->head->link.delta = 0;
+		this->collect();
+	}
+}
+
+void sleep_queue::collect(void) {
+	while (this->head != nullptr && this->head->link.delta == 0) {
+		task *t = this->head;
+
+		this->remove(*t);
+		t->wake();
+
+		t->link.next = this->expired;	// Expired chain is linked through the same fields
+		if (this->expired != nullptr) this->expired->link.prev = t;
+		this->expired = t;
+		t->link.state = link_state::expired;
+	}
+}
+
+/**
+ * Unlinks a task from the expired chain
+ */
+
+void sleep_queue::unchain(task &t) {
+	if (t.link.prev != nullptr) t.link.prev->link.next = t.link.next;
+	else this->expired = t.link.next;
+
+	if (t.link.next != nullptr) t.link.next->link.prev = t.link.prev;
+
+	t.link.next = nullptr;
+	t.link.prev = nullptr;
+	t.link.state = link_state::detached;
+}
+
+/**
+ * Hands back one expired task at a time
+ */
+
+task *sleep_queue::pop_expired(void) {
+	task *t = this->expired;
+	if (t != nullptr) this->unchain(*t);
+
+	return t;
+}
@@ -0,0 +1,71 @@
+/*
+ * sleep_queue.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef SLEEP_QUEUE_H_
+#define SLEEP_QUEUE_H_
+
+#include <task.h>
+
+#include <cstddef>
+
+/**
+ * Kernel timer queue for sleeping tasks, kept as a sorted delta list: each sleeper stores only the number of
+ * ticks between its own wake-up and that of the sleeper ahead of it (link.delta). A tick therefore decrements
+ * the head alone and pops every sleeper that reached zero - O(expired) instead of O(sleepers). Woken tasks are
+ * handed back through pop_expired() so the scheduler can make them ready again. Until then they sit on the expired
+ * chain, which remove() unlinks them from just like the sleep list - a task unblocked or cleaned up in between
+ * leaves it rather than dragging the sleepers behind it along.
+ */
+
+class sleep_queue {
+public:
+	sleep_queue();
+
+	// Parks a task for the number of ticks in its sleep counter
+	void insert(task &t);
+
+	// Pulls a task out early, or off the expired chain if it already woke up
+	void remove(task &t);
+
+	// Advances the head sleeper by one tick and collects everyone who is due
+	void tick(void);
+
+	// Advances the sleepers by several ticks at once, e.g. after the tick was stopped
+	void advance(std::size_t ticks);
+
+	// Returns the next task whose sleep expired, or nullptr once there are none left
+	task *pop_expired(void);
+
+	// Drops every sleeper
+	void clear(void);
+
+	// Ticks until the head sleeper wakes up, 0 if nobody is asleep
+	inline std::size_t next_expiry(void) const;
+
+	// Whether woken sleepers are still waiting for pop_expired()
+	inline bool has_expired(void) const;
+
+private:
+	// Moves every sleeper at the head whose delta ran out onto the expired chain
+	void collect(void);
+
+	// Takes a task off the expired chain
+	void unchain(task &t);
+
+	task *head;
+	task *expired;
+};
+
+inline std::size_t sleep_queue::next_expiry(void) const {
+	return (this->head != nullptr) ? this->head->link.delta : 0;
+}
+
+inline bool sleep_queue::has_expired(void) const {
+	return this->expired != nullptr;
+}
+
+#endif /* SLEEP_QUEUE_H_ */
@@ -0,0 +1,49 @@
+/*
+ * slice_timer.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <slice_timer.h>
+
+#ifdef SLICE_TIMER
+
+static std::uint16_t tick_base = 0;	// Timer_A0 count at the last tick boundary
+
+void slice_timer_init(void) {
+	TA0CCTL0 = 0;
+	TA0CTL = TASSEL_1 | ID_0 | MC_2 | TACLR;	// ACLK, undivided, continuous
+	tick_base = 0;
+}
+
+/**
+ * Called from context_switch() with interrupts disabled
+ */
+
+std::size_t slice_timer_elapsed(void) {
+	const std::uint16_t ticks = static_cast<std::uint16_t>(TA0R - tick_base) / slice_counts_per_tick;
+	tick_base += ticks * slice_counts_per_tick;
+
+	return ticks;
+}
+
+/**
+ * Counts from the last tick boundary, so slices stay in step with the ticks - the compare always lands at least a
+ * full tick after the boundary, which is ahead of the counter unless the switch itself took longer than that
+ */
+
+void slice_timer_arm(std::size_t quantum, std::size_t wakeup) {
+	std::size_t ticks = quantum;
+	if (wakeup > 0 && wakeup < ticks) ticks = wakeup;
+	if (ticks == 0) ticks = 1;
+	if (ticks > slice_max_ticks) ticks = slice_max_ticks;
+
+	std::uint16_t compare = tick_base + static_cast<std::uint16_t>(ticks * slice_counts_per_tick);
+	while (static_cast<std::int16_t>(compare - TA0R) <= 0) compare += slice_counts_per_tick;
+
+	TA0CCR0 = compare;
+	TA0CCTL0 = CCIE;	// Clears a stale CCIFG along the way
+}
+
+#endif
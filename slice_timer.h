@@ -0,0 +1,43 @@
+/*
+ * slice_timer.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef SLICE_TIMER_H_
+#define SLICE_TIMER_H_
+
+#include <msp430.h>
+#include <config.h>
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Variable-length time slices. With SLICE_TIMER defined, preemption comes from a Timer_A0 compare instead of the
+ * watchdog interval: Timer_A0 runs free from ACLK, and every task load sets CCR0 for the end of that task's slice -
+ * task::get_quantum() ticks, or fewer if a sleeper is due earlier, so sleeps still end on time. The watchdog stays
+ * held in interval mode and only carries the switches the kernel requests itself.
+ *
+ * A tick is still 64 ACLK cycles, the WDT_ADLY_1_9 interval, and remains the unit of sleeps, periods and quanta.
+ * At every switch the kernel catches up on the whole ticks that passed since the last one, so a slice of n ticks
+ * advances kernel time by n, and a switch requested in the middle of a tick takes none of its own.
+ *
+ * Timer_A1 belongs to the profiler and the CPU accounting, Timer_B0 to the tickless idle. With TICKLESS_IDLE also
+ * defined, the idle hook's slice already lasts until the first sleeper is due, so it only has to sleep deeper.
+ */
+
+constexpr std::uint16_t slice_counts_per_tick = 64;	// ACLK cycles per tick
+constexpr std::size_t slice_max_ticks = 0x7FFF / slice_counts_per_tick;	// Compares stay within half the counter range
+
+// Starts Timer_A0 - the first slice is set when the first task loads
+void slice_timer_init(void);
+
+// Moves the tick boundary past the whole ticks since the last switch and returns how many there were
+std::size_t slice_timer_elapsed(void);
+
+// Sets the compare for the end of the next slice - quantum ticks, cut short to wakeup ticks if that is nonzero
+void slice_timer_arm(std::size_t quantum, std::size_t wakeup);
+
+#endif /* SLICE_TIMER_H_ */
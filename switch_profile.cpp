@@ -0,0 +1,110 @@
+/*
+ * switch_profile.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <switch_profile.h>
+#include <bitops.h>
+#include <print.h>
+
+#ifdef SWITCH_PROFILING
+
+switch_profile_data switch_profile;
+volatile std::uint16_t switch_stamps[num_switch_points];
+
+static const char *const phase_names[num_switch_phases] = { "save", "schedule", "restore", "total" };
+
+void switch_profile_init(void) {
+	TA1CTL = TASSEL_2 | ID_0 | MC_2 | TACLR;	// SMCLK, undivided, continuous up to 0xFFFF
+	switch_profile_reset();
+}
+
+void switch_profile_reset(void) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+
+	switch_profile.switches = 0;
+	switch_profile.resumes = 0;
+	switch_profile.resume_total = 0;
+	for (switch_phase_stats &p : switch_profile.phases) {
+		p.min = 0xFFFF;
+		p.max = 0;
+		p.total = 0;
+		for (std::uint16_t &count : p.histogram) count = 0;
+	}
+
+	_set_interrupt_state(state);
+}
+
+static void record_phase(switch_phase_stats &p, std::uint16_t cycles) {
+	if (cycles < p.min) p.min = cycles;
+	if (cycles > p.max) p.max = cycles;
+	p.total += cycles;
+
+	std::uint16_t &count = p.histogram[(cycles != 0) ? msb16(cycles) : 0];
+	if (count != 0xFFFF) ++count;
+}
+
+/**
+ * Called with interrupts disabled once the loaded stamp is taken. The timer wraps every 65536 cycles, which no
+ * single switch comes close to, so plain 16-bit differences are exact.
+ */
+
+void switch_profile_record(bool resumed) {
+	const std::uint16_t entry = switch_stamps[switch_entry];
+	const std::uint16_t saved = switch_stamps[switch_saved];
+	const std::uint16_t scheduled = switch_stamps[switch_scheduled];
+	const std::uint16_t loaded = switch_stamps[switch_loaded];
+
+	record_phase(switch_profile.phases[phase_save], saved - entry);
+	record_phase(switch_profile.phases[phase_schedule], scheduled - saved);
+	record_phase(switch_profile.phases[phase_restore], loaded - scheduled);
+	record_phase(switch_profile.phases[phase_total], loaded - entry);
+
+	switch_profile.switches++;
+
+	if (resumed) {
+		switch_profile.resumes++;
+		switch_profile.resume_total += loaded - entry;
+	}
+}
+
+/**
+ * Prints a snapshot of the figures - taken with interrupts disabled so the phases agree with each other
+ */
+
+void switch_profile_dump(void) {
+	std::uint16_t state = _get_interrupt_state();
+	_disable_interrupt();
+	const switch_profile_data snapshot = switch_profile;
+	_set_interrupt_state(state);
+
+	uart_format(format_string("switch profile: %n switches, SMCLK cycles\r\n"), snapshot.switches);
+	if (snapshot.switches == 0) return;
+
+	for (std::uint8_t i = 0; i < num_switch_phases; ++i) {
+		const switch_phase_stats &p = snapshot.phases[i];
+		uart_format(format_string("%s: min %u mean %n max %u\r\n"), phase_names[i], p.min,
+				p.total / snapshot.switches, p.max);
+
+		for (std::uint8_t b = 0; b < switch_histogram_buckets; ++b) {
+			if (p.histogram[b] == 0) continue;
+			uart_format(format_string("  < %n: %u\r\n"), static_cast<std::uint32_t>(2ul << b), p.histogram[b]);
+		}
+	}
+
+	// What a resume costs against a full switch - the difference is what each one saved
+	if (snapshot.resumes == 0 || snapshot.resumes == snapshot.switches) return;
+
+	const std::uint32_t resume_mean = snapshot.resume_total / snapshot.resumes;
+	const std::uint32_t full_mean = (snapshot.phases[phase_total].total - snapshot.resume_total) /
+			(snapshot.switches - snapshot.resumes);
+	const std::uint32_t saved = (full_mean > resume_mean) ? full_mean - resume_mean : 0;
+
+	uart_format(format_string("resumed in place: %n of %n, mean %n against %n, %n saved\r\n"), snapshot.resumes,
+			snapshot.switches, resume_mean, full_mean, saved * snapshot.resumes);
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * switch_profile.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef SWITCH_PROFILE_H_
+#define SWITCH_PROFILE_H_
+
+#include <msp430.h>
+#include <config.h>
+
+#include <cstdint>
+
+/**
+ * Context switch profiler. With SWITCH_PROFILING defined, Timer_A1 runs free from SMCLK and every context switch
+ * is timestamped at four points:
+ *
+ *     entry      - preempt() has been taken and context_switch() begins
+ *     saved      - save_context() has stored the outgoing task
+ *     scheduled  - the next task has been chosen
+ *     loaded     - right before ctx_load() jumps into it
+ *
+ * The phases in between (save, schedule, restore, and the whole switch) are folded into min / max / mean and a
+ * log2 histogram once the last stamp is taken, so the bookkeeping itself is never part of a measurement. Durations
+ * are in SMCLK cycles, which are CPU cycles as long as SMCLK and MCLK share a source and divider.
+ *
+ * A tick that leaves the running task in place (see scheduler::resume_current()) still counts as a switch, and is
+ * counted once more on its own. The dump sets their mean against that of the full switches for the cycles the
+ * shortcut saves - a lower bound, as the registers ctx_load() would reload lie past the last stamp.
+ *
+ * switch_profile_dump() prints the figures over the UART. The figures also sit in the switch_profile struct, so a
+ * debugger can read them with the target halted - tools/switch_profile.gdb does this on the msp430-elf GDB
+ * simulator. Without SWITCH_PROFILING the stamps compile to nothing and the rest is left out of the build.
+ */
+
+enum switch_point : std::uint8_t {
+	switch_entry,
+	switch_saved,
+	switch_scheduled,
+	switch_loaded,
+	num_switch_points
+};
+
+enum switch_phase : std::uint8_t {
+	phase_save,			// entry -> saved
+	phase_schedule,		// saved -> scheduled
+	phase_restore,		// scheduled -> loaded
+	phase_total,		// entry -> loaded
+	num_switch_phases
+};
+
+constexpr std::uint8_t switch_histogram_buckets = 16;	// Bucket b counts durations of [2^b, 2^(b+1)) cycles
+
+struct switch_phase_stats {
+	std::uint16_t min;
+	std::uint16_t max;
+	std::uint32_t total;
+	std::uint16_t histogram[switch_histogram_buckets];	// Saturates at 0xFFFF
+};
+
+struct switch_profile_data {
+	std::uint32_t switches;
+	std::uint32_t resumes;			// Switches that found the running task picked again and left it in place
+	std::uint32_t resume_total;		// Their entry -> loaded cycles, which phase_total counts as well
+	switch_phase_stats phases[num_switch_phases];
+};
+
+extern switch_profile_data switch_profile;
+extern volatile std::uint16_t switch_stamps[num_switch_points];
+
+// Starts the free-running timer and clears the figures
+void switch_profile_init(void);
+void switch_profile_reset(void);
+
+// Folds the stamps of the switch in progress into the figures - resumed for a tick that kept the running task
+void switch_profile_record(bool resumed);
+
+// Prints the figures over the UART
+void switch_profile_dump(void);
+
+/**
+ * Takes a timestamp. A single memory-to-memory move, so it is safe ahead of ctx_save - no register is touched.
+ */
+
+__attribute__((always_inline)) inline void switch_stamp(switch_point point) {
+#ifdef SWITCH_PROFILING
+	switch_stamps[point] = TA1R;
+#else
+	(void) point;
+#endif
+}
+
+#endif /* SWITCH_PROFILE_H_ */
@@ -7,26 +7,48 @@
 
 #include <task.h>
 #include <scheduler.h>
+#include <format.h>
+#include <tickless.h>
 
-const std::string thread_info::to_string(void) {
-	std::string msg;
-	msg += "-----------\n\r";
+std::size_t thread_info::to_string(char *buf, std::size_t size) const {
+	if (size == 0) return 0;
+
+	format_sink out(buf, size - 1);	// Leave room for the terminator
+	format_to(out, format_string("-----------\n\r"));
 #ifdef DEBUG_MODE
-	msg += "Name: ";
+	format_to(out, format_string("Name: "));
 #else
 #endif
-	msg += "Priority: " + std::to_string(this->priority) + "\n\r";
-	msg += "Stack Size: " + std::to_string(this->stack_size) + "\n\r";
-	msg += "Stack Usage: " + std::to_string(this->stack_usage) + "\n\r";
-	msg += "Times Run: " + std::to_string(this->ticks) + "\n\r";
-	return msg;
+	format_to(out, format_string("Priority: %u\n\rStack Size: %u\n\rStack Usage: %u\n\rTimes Run: %u\n\rCycles Run: %n\n\r"),
+			this->priority, this->stack_size, this->stack_usage, this->ticks, this->cycles);
+
+	buf[out.size()] = '\0';
+	return out.size();
 }
 
 /**
  * Idle task - sets system in low power mode
  */
 
-task task::idle_hook = task(task::idle, 32);
+#ifdef STATIC_KERNEL
+static std::uint16_t idle_stack[TASK_STACK_MIN];
+task task::idle_hook(task::idle, idle_stack, TASK_STACK_MIN);
+#else
+task task::idle_hook = task(task::idle, TASK_STACK_MIN);
+#endif
+
+/**
+ * Words to allocate for a stack of the requested size - never less than a preemption needs, and host tasks also run
+ * libc and signal frames on theirs
+ */
+
+static constexpr std::size_t stack_words(std::size_t stack_size) {
+#ifdef HOST_PORT
+	return (stack_size < HOST_STACK_WORDS) ? HOST_STACK_WORDS : stack_size;
+#else
+	return (stack_size < TASK_STACK_MIN) ? TASK_STACK_MIN : stack_size;
+#endif
+}
 
 /**
  * Default constructor
@@ -35,6 +57,7 @@ task task::idle_hook = task(task::idle, 32);
 task::task() {
 	// No stack allocated yet
 	this->ustack = std::unique_ptr<std::uint16_t []>(nullptr);
+	this->stack_mem = nullptr;
 
 	// No code associated with the thread yet
 	this->runnable = nullptr;
@@ -43,13 +66,23 @@ task::task() {
 	this->info = {
 			.id = 0,
 			.priority = 0,
+			.quantum = 0,
 			.stack_size = 0,
 			.stack_usage = 0,
 			.ticks = 0,
+			.cycles = 0,
 			.sleep_ticks = 0,
 			.blocked = true,
-			.complete = true
+			.complete = true,
+			.period = 0,
+			.wcet = 0,
+			.deadline = 0,
+			.release = 0,
+			.deadline_misses = 0,
+			.overrun = false
 	};
+
+	this->link = sched_link();
 }
 
 /**
@@ -58,10 +91,35 @@ task::task() {
  * @param stack_size - size of allocated stack address space
  * @param priority - task run queue priority
  */
+
+task::task(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t priority, bool blocking)
+	: task(runnable, new std::uint16_t[stack_words(stack_size)], stack_words(stack_size), priority, blocking) {
+	// Take ownership of the freshly allocated process stack
+	this->ustack.reset(this->stack_mem);
+}
+
+/**
+ * Constructor for a task from its configuration entry, running on caller-provided stack memory
+ * @param cfg - task configuration
+ * @param stack - stack memory of at least cfg.stack_size words, must outlive the task
+ */
+
+task::task(const task_config &cfg, std::uint16_t *stack) : task(cfg.func, stack, cfg.stack_size, cfg.priority) {
+	this->set_timing(cfg.period, cfg.wcet, cfg.deadline);
+	this->set_quantum(cfg.quantum);
+}
+
+/**
+ * Constructor for a task running on caller-provided stack memory (e.g. statically allocated)
+ * @param runnable - pointer to executable function
+ * @param stack - stack memory of at least stack_size words, must outlive the task
+ * @param stack_size - size of the stack address space
+ * @param priority - task run queue priority
+ */
 static std::uint16_t tid = 1;
-task::task(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t priority, bool blocking) {
-	// Allocate process stack
-	this->ustack = std::make_unique<std::uint16_t []>(stack_size);
+task::task(std::int16_t (*runnable)(void), std::uint16_t *stack, std::size_t stack_size, std::uint8_t priority, bool blocking) {
+	// Use the provided process stack without taking ownership
+	this->stack_mem = stack;
 
 	// Initialize runnable to passed-in function
 	this->runnable = runnable;
@@ -70,19 +128,32 @@ task::task(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t
 	this->info = {
 			.id = tid++,
 			.priority = priority,
+			.quantum = 0,
 			.stack_size = stack_size,
 			.stack_usage = 0,
 			.ticks = 0,
+			.cycles = 0,
 			.sleep_ticks = 0,
 			.blocked = blocking,
-			.complete = false
+			.complete = false,
+			.period = 0,
+			.wcet = 0,
+			.deadline = 0,
+			.release = 0,
+			.deadline_misses = 0,
+			.overrun = false
 	};
 
+	// Not linked into any scheduler structure until the scheduler picks it up
+	this->link = sched_link();
+
 	/**
 	 * Writes address of executable to PC location of TCB and top of the stack to SP location
 	 */
 
-#if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+#if defined(HOST_PORT)
+	host_context_init(this->context[0], runnable, this->stack_mem, sizeof(this->stack_mem[0]) * stack_size);
+#elif defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
 	this->context[8] = reinterpret_cast<std::uint32_t>(runnable);
 	this->context[7] = stack_base(this);
 #else
@@ -108,8 +179,9 @@ task &task::operator=(const task &other) {
 	new (this) task(other.runnable, other.info.stack_size, other.info.priority); // Copy basic task structure first
 	this->info = other.info; // Update thread states
 
+#ifndef HOST_PORT
 	// Copy whole stack (can be optimized)
-	std::memcpy(this->ustack.get(), other.ustack.get(), sizeof(other.ustack[0]) * other.info.stack_size);
+	std::memcpy(this->stack_mem, other.stack_mem, sizeof(other.stack_mem[0]) * other.info.stack_size);
 
 	// Copy the context
 	std::memcpy(&this->context, &other.context, sizeof(other.context));
@@ -121,9 +193,40 @@ task &task::operator=(const task &other) {
 
 	// Apply this offset to MY base
 	set_task_sp(this, dst_stack_base - stack_usage_state);
+#else
+	// A suspended host context cannot be relocated, so the copy starts over from its entry point
+#endif
 	return *this;
 }
 
+/**
+ * Records where a preempted task left its registers. ctx_preempt() has pushed the full frame on the task's own stack,
+ * so the TCB only keeps the frame's address, and a ctx_load() of the task lands in ctx_frame_return(), which pops
+ * the frame and returns from the interrupt. The host port keeps the interrupted frame in a ucontext instead.
+ */
+
+void task::park(void *frame) {
+#if defined(HOST_PORT)
+	(void) frame;	// The interrupted registers are in the ucontext that ctx_save() fills in
+	ctx_save(this->context);
+#elif defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+	this->context[8] = reinterpret_cast<std::uint32_t>(&ctx_frame_return);
+	this->context[7] = reinterpret_cast<std::uint32_t>(frame);
+#else
+	this->context[8] = reinterpret_cast<std::uint16_t>(&ctx_frame_return);
+	this->context[7] = reinterpret_cast<std::uint16_t>(frame);
+#endif
+}
+
+/**
+ * System call entry - saves the callee-saved context and runs the kernel on its own stack. Returns once the task
+ * is loaded again.
+ */
+
+void task::trap(void *kstack, void (*kernel)(void)) {
+	ctx_trap(this->context, kstack, kernel);
+}
+
 /**
  * Context switching function which activates a new process
  */
@@ -137,14 +240,26 @@ void task::load(void) {
 	ctx_load(this->context);
 }
 
+/**
+ * Hands a task parked a moment ago its next slice in place - its frame is still where the tick left it, so nothing
+ * is loaded and only the tick is re-armed before the frame is popped
+ */
+
+void task::resume(void) {
+	this->info.ticks++;
+
+#if defined(HOST_PORT)
+	ctx_load(this->context);
+#else
+	ctx_frame_resume(reinterpret_cast<void *>(this->context[7]));
+#endif
+}
+
 /**
  * Function that updates task resource monitors
  */
 
 void task::update(void) {
-	// Update sleep state and stack usage figure
-	if (this->info.sleep_ticks > 0) this->info.sleep_ticks--;
-
 	// Grab the base of the stack and calculate the distance between the last known location of the top and this base
 	this->info.stack_usage = this->get_stack_usage();
 }
@@ -172,6 +287,14 @@ void task::sleep(const std::size_t ticks) {
 	else this->info.sleep_ticks = ticks;
 }
 
+/**
+ * Clears the sleep counter once the sleep has run its course
+ */
+
+void task::wake(void) {
+	this->info.sleep_ticks = 0;
+}
+
 /**
  * Puts task to sleep until signalled / notified by another thread
  */
@@ -188,6 +311,60 @@ void task::unblock(void) {
 	this->info.blocked = false;
 }
 
+/**
+ * Changes the task's scheduling weight
+ */
+
+void task::set_priority(const std::uint8_t priority) {
+	this->info.priority = priority;
+}
+
+/**
+ * Changes the length of the task's time slice, in ticks
+ */
+
+void task::set_quantum(const std::uint8_t quantum) {
+	this->info.quantum = quantum;
+}
+
+/**
+ * Sets the real-time parameters of the task, in ticks
+ */
+
+void task::set_timing(const std::uint16_t period, const std::uint16_t wcet, const std::uint16_t deadline) {
+	this->info.period = period;
+	this->info.wcet = wcet;
+	this->info.deadline = (deadline > 0) ? deadline : period;
+}
+
+/**
+ * Starts a new job of a periodic task at the given tick
+ */
+
+void task::release(const std::uint32_t tick) {
+	this->info.release = tick;
+	this->info.overrun = false;
+}
+
+/**
+ * Records a job that ran past its deadline - once, however often it is caught
+ */
+
+void task::miss_deadline(void) {
+	if (this->info.overrun) return;
+
+	this->info.deadline_misses++;
+	this->info.overrun = true;
+}
+
+/**
+ * Adds the cycles of a slice that just ended to the task's run time
+ */
+
+void task::charge(const std::uint32_t cycles) {
+	this->info.cycles += cycles;
+}
+
 /**
  * Kills task
  */
@@ -200,7 +377,12 @@ void task::ret(void) {
  * Fetches last known location of the top of the stack
  */
 
-#if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+#if defined(HOST_PORT)
+std::uintptr_t task::get_task_sp(void) const {
+	const std::uintptr_t sp = host_context_sp(this->context[0]);
+	return (sp != 0) ? sp : stack_base(this);
+}
+#elif defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
 std::uint32_t task::get_task_sp(void) const {
 	return this->context[7];
 }
@@ -213,6 +395,41 @@ std::uint16_t task::get_task_sp(void) const {
 std::size_t task::get_stack_usage(void) const {
 	return stack_base(this) - this->get_task_sp();
 }
+
+/**
+ * Fetches the address the task resumes at - for a preempted task that is the PC in its interrupt frame, past the
+ * twelve registers ctx_preempt() pushed
+ */
+
+#if defined(HOST_PORT)
+std::uintptr_t task::get_resume_pc(void) const {
+	return host_context_pc(this->context[0]);
+}
+#elif defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+std::uint32_t task::get_resume_pc(void) const {
+	if (this->context[8] != reinterpret_cast<std::uint32_t>(&ctx_frame_return)) return this->context[8];
+
+	// PUSHM.A stores two words per register, and the SR word carries PC[19:16] in its top bits
+	const std::uint16_t *frame = reinterpret_cast<const std::uint16_t *>(this->context[7]) + 24;
+	return static_cast<std::uint32_t>(frame[0] & 0xF000) << 4 | frame[1];
+}
+#else
+std::uint16_t task::get_resume_pc(void) const {
+	if (this->context[8] != reinterpret_cast<std::uint16_t>(&ctx_frame_return)) return this->context[8];
+
+	const std::uint16_t *frame = reinterpret_cast<const std::uint16_t *>(this->context[7]) + 12;
+	return frame[1];
+}
+#endif
+
+/**
+ * Fetches task id
+ */
+
+std::uint16_t task::get_tid() const {
+	return this->info.id;
+}
+
 /**
  * Fetches task priority
  */
@@ -221,6 +438,14 @@ std::uint8_t task::get_priority() const {
 	return this->info.priority;
 }
 
+/**
+ * Fetches the length of the task's time slice in ticks - at least one
+ */
+
+std::uint8_t task::get_quantum() const {
+	return (this->info.quantum > 0) ? this->info.quantum : 1;
+}
+
 /**
  * Fetches resource monitor struct
  */
@@ -245,6 +470,22 @@ bool task::blocking(void) const {
 	return this->info.blocked;
 }
 
+/**
+ * Asserts if task has real-time parameters
+ */
+
+bool task::periodic(void) const {
+	return this->info.period > 0;
+}
+
+/**
+ * Tick by which the current job has to complete
+ */
+
+std::uint32_t task::absolute_deadline(void) const {
+	return this->info.release + this->info.deadline;
+}
+
 /**
  * Asserts if task is done
  */
@@ -253,9 +494,14 @@ bool task::complete(void) const {
 	return this->info.complete;
 }
 
-#if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+#if defined(HOST_PORT)
+std::uintptr_t task::stack_base(const task *t) {
+	return reinterpret_cast<std::uintptr_t>(t->stack_mem + t->info.stack_size);
+}
+
+#elif defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
 std::uint32_t task::stack_base(const task *t) {
-	return reinterpret_cast<std::uint32_t>(t->ustack.get() + t->info.stack_size);
+	return reinterpret_cast<std::uint32_t>(t->stack_mem + t->info.stack_size);
 }
 
 void task::set_task_sp(task *t, std::uint32_t val) {
@@ -264,7 +510,7 @@ void task::set_task_sp(task *t, std::uint32_t val) {
 
 #else
 std::uint16_t task::stack_base(const task *t) {
-	return reinterpret_cast<std::uint16_t>(t->ustack.get() + t->info.stack_size);
+	return reinterpret_cast<std::uint16_t>(t->stack_mem + t->info.stack_size);
 }
 
 void task::set_task_sp(task *t, std::uint16_t val) {
@@ -277,6 +523,10 @@ void task::set_task_sp(task *t, std::uint16_t val) {
  */
 
 std::int16_t task::idle(void) {
+#ifdef TICKLESS_IDLE
+	for (;;) tickless_idle();
+#else
 	for (;;) _low_power_mode_0();
+#endif
 	return 0;
 }
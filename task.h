@@ -9,15 +9,18 @@
 #define TASK_H_
 
 #include <msp430.h>
+#include <config.h>
 
 #include <cstdint>
 
 #include <memory>
-#include <string>
 
 class task;
 
-#if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+#if defined(HOST_PORT)
+	#include <host_port.h>
+	using ctx = host_context[1];
+#elif defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
 	using ctx = std::uint32_t[9];
 #else
 	using ctx = std::uint16_t[9];
@@ -25,6 +28,48 @@ class task;
 
 extern "C" int ctx_save(ctx env);
 extern "C" void ctx_load(ctx env);
+extern "C" void ctx_trap(ctx env, void *kstack, void (*kernel)(void));
+extern "C" void ctx_preempt(void);
+extern "C" void ctx_frame_return(void);
+extern "C" void ctx_frame_resume(void *frame);
+
+/**
+ * Which scheduler structure currently holds a task
+ */
+
+enum class link_state : std::uint8_t {
+	detached,	// Not tracked by any scheduler list (blocked, complete, interrupt handler or idle)
+	ready,		// Linked into the ready queue / heap of the active scheduling algorithm
+	sleeping,	// Linked into the kernel sleep list
+	expired		// Woken sleeper on the sleep queue's expired chain, waiting for the scheduler to take it
+};
+
+/**
+ * Intrusive scheduler linkage - owned and maintained by the scheduler, never by the task itself
+ */
+
+struct sched_link {
+	task *next = nullptr;
+	task *prev = nullptr;
+
+	std::uint32_t key = 0;		// Algorithm-specific sort key (e.g. stride pass value, absolute deadline)
+	std::uint16_t stride = 0;	// Pass increment per slice for the stride scheduler
+	std::size_t delta = 0;		// Ticks between the wake-up of the sleeper ahead and this one
+
+	std::uint16_t round = 0;	// Run queue round those slices belong to
+	std::uint8_t slices = 0;	// Time slices left in the current round
+	std::uint8_t index = 0;		// Algorithm-specific position of the task (e.g. run queue bank, heap slot)
+	std::uint8_t source = 0xFF;	// Interrupt source the task handles, 0xFF for ordinary tasks
+
+	link_state state = link_state::detached;
+
+	task *next_task = nullptr;	// Registry of every task known to the scheduler
+	task *prev_task = nullptr;
+
+	bool enlisted = false;		// Linked into the registry
+	bool attached = false;		// Filed with the scheduling algorithm, one of its MAX_TASKS slots
+	bool owned = false;			// TCB was allocated by the scheduler and is freed on cleanup
+};
 
 /**
  * Resource monitoring struct for task
@@ -33,17 +78,28 @@ extern "C" void ctx_load(ctx env);
 struct thread_info {
 	std::uint16_t id;
 	std::uint8_t priority;
+	std::uint8_t quantum;		// Ticks per slice, 0 for the default of one - see slice_timer.h
 
 	std::size_t stack_size;
 	std::size_t stack_usage;
 
 	std::size_t ticks;
-	std::size_t sleep_ticks;
+	std::uint32_t cycles;		// Time run in Timer_A1 cycles, wrapping - counted with CPU_ACCOUNTING, see cpu_time.h
+	std::size_t sleep_ticks;	// Length of the current sleep, zero once awake (the sleep queue tracks what is left)
 
 	bool blocked;
 	bool complete;
 
-	const std::string to_string(void);
+	// Real-time parameters in ticks (period 0 for background tasks)
+	std::uint16_t period;
+	std::uint16_t wcet;
+	std::uint16_t deadline;
+
+	std::uint32_t release;			// Tick at which the current job was released
+	std::uint16_t deadline_misses;	// Jobs that ran past their deadline
+	bool overrun;					// The current job is past its deadline and counted already
+
+	std::size_t to_string(char *buf, std::size_t size) const;	// NUL-terminated, returns the length
 };
 
 /**
@@ -58,6 +114,8 @@ public:
 	 */
 	task();
 	task(std::int16_t (*runnable)(void), std::size_t stack_size, std::uint8_t priority = 1, bool blocking = false);
+	task(std::int16_t (*runnable)(void), std::uint16_t *stack, std::size_t stack_size, std::uint8_t priority = 1, bool blocking = false);
+	task(const task_config &cfg, std::uint16_t *stack);
 
 	/**
 	 * Copy-ish constructors
@@ -70,8 +128,10 @@ public:
 	 * Context switching functions
 	 */
 
-	__attribute__((always_inline)) inline void pause(void);
+	void park(void *frame);
+	void trap(void *kstack, void (*kernel)(void));
 	void load(void);
+	void resume(void);
 
 	/**
 	 * Scheduling state management functions
@@ -80,19 +140,36 @@ public:
 	void refresh(void);
 	void update(void);
 	void sleep(const std::size_t ticks);
+	void wake(void);
 	void block(void);
 	void unblock(void);
 	void ret(void);
+	void set_priority(const std::uint8_t priority);
+	void set_quantum(const std::uint8_t quantum);
+	void set_timing(const std::uint16_t period, const std::uint16_t wcet, const std::uint16_t deadline);
+	void release(const std::uint32_t tick);
+	void miss_deadline(void);
+	void charge(const std::uint32_t cycles);
 
 	std::uint16_t get_tid(void) const;
 	std::uint8_t get_priority(void) const;
+	std::uint8_t get_quantum(void) const;
 	std::size_t get_stack_size(void) const;
 	std::size_t get_run_count(void) const;
 	std::size_t get_stack_usage(void) const;
+#if defined(HOST_PORT)
+	std::uintptr_t get_resume_pc(void) const;
+#elif defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+	std::uint32_t get_resume_pc(void) const;
+#else
+	std::uint16_t get_resume_pc(void) const;
+#endif
 
 	bool sleeping(void) const;
 	bool blocking(void) const;
 	bool complete(void) const;
+	bool periodic(void) const;
+	std::uint32_t absolute_deadline(void) const;
 	const thread_info &get_state(void) const;
 
 	/**
@@ -114,6 +191,12 @@ public:
 		return t1.info.id == t2.info.id;
 	}
 
+	/**
+	 * Scheduler bookkeeping (run queue / sleep list membership)
+	 */
+
+	sched_link link;
+
 private:
 
 	/**
@@ -122,6 +205,12 @@ private:
 
 	std::unique_ptr<std::uint16_t []> ustack;
 
+	/**
+	 * Base of the stack memory - owned through ustack, or statically allocated when ustack is empty
+	 */
+
+	std::uint16_t *stack_mem = nullptr;
+
 	/**
 	 * Thread context block
 	 */
@@ -144,7 +233,10 @@ private:
 	 * State information retrieval functions
 	 */
 
-#if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
+#if defined(HOST_PORT)
+	std::uintptr_t get_task_sp(void) const;
+	static std::uintptr_t stack_base(const task *t);
+#elif defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
 	std::uint32_t get_task_sp(void) const;
 	static std::uint32_t stack_base(const task *t);
 	static void set_task_sp(task *t, std::uint32_t val);
@@ -156,42 +248,4 @@ private:
 };
 
 
-/**
- * Thread context switching function which saves current task context and performs stack modification to
- * realign stack after an interrupt
- */
-
-__attribute__((always_inline)) inline void task::pause(void) {
-
-	// Save task context
-	ctx_save(this->context);
-
-	/**
-	 * Interrupt pushes PC + SR to stack, must retrieve them, store them in the TCB and unroll the stack
-	 */
-
-#if defined(__LARGE_CODE_MODEL__) || defined(__LARGE_DATA_MODEL__)
-	// Fetches bytes of pushed PC words
-	const register std::uint16_t *stack_top = reinterpret_cast<std::uint16_t *>(__get_SP_register());
-	const register std::uint16_t top_pc_bits = (*(stack_top) & 0xF000) >> 12;
-
-	// Rolls back stack to deallocate words
-	__set_SP_register(__get_SP_register() + 4);
-
-	// Writes pushed PC from interrupt into TCB as pointer to next normal instruction and SP for proper SP location
-	this->context[8] = static_cast<std::uint32_t>(top_pc_bits) << 16 | *(stack_top + 1);
-	this->context[7] = __get_SP_register();
-#else
-	// Fetches bytes of pushed PC words
-	const register std::uint16_t *stack_top = reinterpret_cast<std::uint16_t *>(__get_SP_register());
-
-	// Rolls back stack to deallocate words
-	__set_SP_register(__get_SP_register() + 4);
-
-	// Writes pushed PC from interrupt into TCB as pointer to next normal instruction and SP for proper SP location
-	this->context[8] = *(stack_top + 1);
-	this->context[7] = __get_SP_register();
-#endif
-}
-
 #endif /* TASK_H_ */
@@ -0,0 +1,112 @@
+/*
+ * task_heap.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef TASK_HEAP_CPP_
+#define TASK_HEAP_CPP_
+
+#include <task_heap.h>
+
+template <class Compare, std::size_t N>
+task_heap<Compare, N>::task_heap() : size_(0) { }
+
+template <class Compare, std::size_t N>
+inline void task_heap<Compare, N>::place(std::size_t idx, task *t) {
+	nodes_[idx] = t;
+	t->link.index = static_cast<std::uint8_t>(idx);	// Remember the slot for O(log n) removal
+}
+
+template <class Compare, std::size_t N>
+inline void task_heap<Compare, N>::sift_up(std::size_t idx) {
+	task *t = nodes_[idx];
+
+	while (idx > 0) {	// Bubble towards the root while we beat the parent
+		const std::size_t parent = (idx - 1) >> 1;
+		if (!comp_(t, nodes_[parent])) break;
+
+		place(idx, nodes_[parent]);
+		idx = parent;
+	}
+
+	place(idx, t);
+}
+
+template <class Compare, std::size_t N>
+inline void task_heap<Compare, N>::sift_down(std::size_t idx) {
+	task *t = nodes_[idx];
+
+	for (;;) {	// Sink while either child beats us
+		std::size_t child = (idx << 1) + 1;
+		if (child >= size_) break;
+
+		if (child + 1 < size_ && comp_(nodes_[child + 1], nodes_[child])) child++;
+		if (!comp_(nodes_[child], t)) break;
+
+		place(idx, nodes_[child]);
+		idx = child;
+	}
+
+	place(idx, t);
+}
+
+template <class Compare, std::size_t N>
+inline bool task_heap<Compare, N>::push(task &t) {
+	if (size_ == N) return false;
+
+	place(size_, &t);
+	sift_up(size_++);
+	return true;
+}
+
+template <class Compare, std::size_t N>
+inline void task_heap<Compare, N>::remove(task &t) {
+	const std::size_t idx = t.link.index;
+	if (idx >= size_ || nodes_[idx] != &t) return;	// Not in this heap
+
+	task *last = nodes_[--size_];
+	if (idx == size_) return;	// Removed the last leaf, nothing to repair
+
+	// Move the last leaf into the hole and let it settle in whichever direction it belongs
+	place(idx, last);
+	sift_up(idx);
+	sift_down(last->link.index);
+}
+
+template <class Compare, std::size_t N>
+inline void task_heap<Compare, N>::update(task &t) {
+	const std::size_t idx = t.link.index;
+	if (idx >= size_ || nodes_[idx] != &t) return;
+
+	sift_up(idx);
+	sift_down(t.link.index);
+}
+
+template <class Compare, std::size_t N>
+inline task *task_heap<Compare, N>::top() const {
+	return (size_ > 0) ? nodes_[0] : nullptr;
+}
+
+template <class Compare, std::size_t N>
+inline void task_heap<Compare, N>::clear() {
+	size_ = 0;
+}
+
+template <class Compare, std::size_t N>
+inline bool task_heap<Compare, N>::empty() const {
+	return size_ == 0;
+}
+
+template <class Compare, std::size_t N>
+inline std::size_t task_heap<Compare, N>::size() const {
+	return size_;
+}
+
+template <class Compare, std::size_t N>
+inline std::size_t task_heap<Compare, N>::capacity() const {
+	return N;
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * task_heap.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef TASK_HEAP_H_
+#define TASK_HEAP_H_
+
+#include <task.h>
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Fixed-capacity binary min-heap of task pointers. Each task remembers its slot in link.index, so arbitrary
+ * removal is O(log n) as well. Nothing is allocated after construction, which keeps it safe to use from the
+ * scheduler tick. Compare(a, b) must return true when a should run before b.
+ */
+
+template <class Compare, std::size_t N>
+class task_heap {
+public:
+	static_assert(N <= 255, "Heap slots are tracked in an 8-bit index");
+
+	task_heap();
+
+	inline bool push(task &t);		// Insert, false if the heap is full
+	inline void remove(task &t);	// Remove from anywhere in the heap
+	inline void update(task &t);	// Restore heap order after the key of t changed
+
+	inline task *top() const;		// Peek at the minimum element
+
+	inline void clear();
+
+	inline bool empty() const;
+	inline std::size_t size() const;
+	inline std::size_t capacity() const;
+
+private:
+	inline void place(std::size_t idx, task *t);
+	inline void sift_up(std::size_t idx);
+	inline void sift_down(std::size_t idx);
+
+	task *nodes_[N];
+	std::size_t size_ = 0;
+	Compare comp_;
+};
+
+#include <task_heap.cpp>
+
+#endif /* TASK_HEAP_H_ */
@@ -0,0 +1,45 @@
+/*
+ * task_table.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <task_table.h>
+
+#ifdef STATIC_KERNEL
+
+#include <utility>
+
+/**
+ * Stack memory of the I-th configured task, sized from its configuration entry
+ */
+
+template <std::size_t I>
+struct task_stack {
+	static std::uint16_t memory[task_cfgs[I].stack_size];
+};
+
+template <std::size_t I>
+__attribute__((section(".task_stacks"))) std::uint16_t task_stack<I>::memory[task_cfgs[I].stack_size];
+
+/**
+ * One task per configuration entry, each constructed in place on its own static stack
+ */
+
+template <class indices>
+struct task_table;
+
+template <std::size_t... I>
+struct task_table<std::index_sequence<I...>> {
+	static task entries[sizeof...(I)];
+};
+
+template <std::size_t... I>
+task task_table<std::index_sequence<I...>>::entries[sizeof...(I)] = {
+	{ task_cfgs[I], task_stack<I>::memory }...
+};
+
+task *const static_tasks = task_table<std::make_index_sequence<num_static_tasks>>::entries;
+
+#endif
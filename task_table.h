@@ -0,0 +1,29 @@
+/*
+ * task_table.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef TASK_TABLE_H_
+#define TASK_TABLE_H_
+
+#include <config.h>
+#include <task.h>
+
+#include <cstddef>
+
+#ifdef STATIC_KERNEL
+
+/**
+ * Compile-time task table generated from task_cfgs. Every task and its stack is laid out statically - the
+ * stacks go to the .task_stacks linker section - so bringing the kernel up allocates and copies nothing.
+ */
+
+constexpr std::size_t num_static_tasks = sizeof(task_cfgs) / sizeof(struct task_config);
+
+extern task *const static_tasks;
+
+#endif
+
+#endif /* TASK_TABLE_H_ */
@@ -0,0 +1,119 @@
+/*
+ * ticket_index.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <ticket_index.h>
+#include <bitops.h>
+
+static_assert(MAX_TASKS < ticket_index::no_slot, "Slots are tracked in an 8-bit index");
+
+/**
+ * Default constructor
+ */
+
+ticket_index::ticket_index() {
+	this->clear();
+}
+
+/**
+ * Releases every slot and empties the pool
+ */
+
+void ticket_index::clear(void) {
+	for (auto &node : this->tree) node = 0;
+	for (auto &count : this->tickets) count = 0;
+	for (auto &owner : this->owners) owner = nullptr;
+
+	this->pool = 0;
+	this->used = 0;
+	this->free_head = no_slot;
+}
+
+/**
+ * Applies a ticket delta to one slot and every partial sum covering it
+ */
+
+void ticket_index::add(std::uint8_t slot, std::int16_t delta) {
+	for (std::uint16_t i = slot + 1; i <= MAX_TASKS; i += i & -i) {
+		this->tree[i] += delta;
+	}
+
+	this->pool += delta;
+}
+
+/**
+ * Gives a task a slot - released slots are reused first. Released slots are chained through their tickets entry.
+ */
+
+bool ticket_index::attach(task &t) {
+	std::uint8_t slot;
+
+	if (this->free_head != no_slot) {
+		slot = this->free_head;
+		this->free_head = static_cast<std::uint8_t>(this->tickets[slot]);
+		this->tickets[slot] = 0;
+	} else if (this->used < MAX_TASKS) {
+		slot = this->used++;
+	} else {
+		t.link.index = no_slot;	// Out of slots - attach() turns the task away
+		return false;
+	}
+
+	this->owners[slot] = &t;
+	t.link.index = slot;
+	return true;
+}
+
+/**
+ * Withdraws a task's tickets and releases its slot
+ */
+
+void ticket_index::detach(task &t) {
+	const std::uint8_t slot = t.link.index;
+	if (slot >= MAX_TASKS || this->owners[slot] != &t) return;
+
+	this->set(t, 0);
+	this->owners[slot] = nullptr;
+	this->tickets[slot] = this->free_head;
+	this->free_head = slot;
+	t.link.index = no_slot;
+}
+
+/**
+ * Updates the number of tickets a task holds in O(log n)
+ */
+
+bool ticket_index::set(task &t, std::uint16_t count) {
+	const std::uint8_t slot = t.link.index;
+	if (slot >= MAX_TASKS || this->owners[slot] != &t) return false;
+
+	const std::int16_t delta = static_cast<std::int16_t>(count - this->tickets[slot]);
+	if (delta == 0) return true;
+
+	this->tickets[slot] = count;
+	this->add(slot, delta);
+	return true;
+}
+
+/**
+ * Descends the tree from the largest power of two, skipping every subtree whose tickets all lie below the roll.
+ * The slot we end up on is the first one whose running sum exceeds the roll.
+ */
+
+task *ticket_index::find(std::uint16_t roll) const {
+	if (roll >= this->pool) return nullptr;
+
+	std::uint16_t pos = 0;
+	for (std::uint16_t step = 1u << msb16(MAX_TASKS); step > 0; step >>= 1) {
+		const std::uint16_t next = pos + step;
+		if (next <= MAX_TASKS && this->tree[next] <= roll) {
+			pos = next;
+			roll -= this->tree[next];
+		}
+	}
+
+	return this->owners[pos];	// pos is the 0-based slot index
+}
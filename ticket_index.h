@@ -0,0 +1,65 @@
+/*
+ * ticket_index.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef TICKET_INDEX_H_
+#define TICKET_INDEX_H_
+
+#include <task.h>
+#include <config.h>
+
+#include <cstdint>
+
+/**
+ * Persistent ticket index for the lottery scheduler - a Fenwick (binary indexed) tree over fixed task slots.
+ *
+ * Every task owns a slot (link.index) for as long as it is registered. Changing the tickets of one slot and
+ * locating the slot that owns a given ticket both take O(log n), and the pool total is kept on the side, so a
+ * draw never rescans the task list or allocates.
+ */
+
+class ticket_index {
+public:
+	static constexpr std::uint8_t no_slot = 0xFF;
+
+	ticket_index();
+
+	// Claims / releases a slot for a task; a fresh slot holds no tickets
+	bool attach(task &t);
+	void detach(task &t);
+
+	// Sets the number of tickets a task holds in the pool, false if it has no slot
+	bool set(task &t, std::uint16_t tickets);
+
+	// Returns the task holding ticket number `roll` in [0, total())
+	task *find(std::uint16_t roll) const;
+
+	// Drops every slot
+	void clear(void);
+
+	inline std::uint16_t total(void) const;
+
+private:
+	void add(std::uint8_t slot, std::int16_t delta);
+
+	std::uint16_t tree[MAX_TASKS + 1];		// 1-based Fenwick tree of partial ticket sums
+	std::uint16_t tickets[MAX_TASKS];		// Tickets currently held by each slot
+	task *owners[MAX_TASKS];				// Task registered in each slot
+
+	std::uint16_t pool;						// Sum of all tickets
+	std::uint8_t used;						// High-water mark of claimed slots
+	std::uint8_t free_head;					// Head of the chain of released slots
+};
+
+/**
+ * Total number of tickets in the draw
+ */
+
+inline std::uint16_t ticket_index::total(void) const {
+	return this->pool;
+}
+
+#endif /* TICKET_INDEX_H_ */
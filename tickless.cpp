@@ -0,0 +1,100 @@
+/*
+ * tickless.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <tickless.h>
+#include <scheduler.h>
+#include <watchdog.h>
+#include <print.h>
+
+#ifdef TICKLESS_IDLE
+
+extern scheduler<scheduling_algorithms::lottery> os;
+
+static bool armed = false;				// The tick is stopped and Timer_B0 stands in for it
+static volatile bool expired = false;	// Timer_B0 ran the full interval
+static std::size_t armed_ticks = 0;
+
+/**
+ * Called by the idle hook with interrupts enabled. The idle hook only runs when no task is ready, so the only
+ * thing the tick still has to do is wake the first sleeper.
+ */
+
+void tickless_idle(void) {
+	_disable_interrupt();
+
+#ifdef SLICE_TIMER
+	// The idle hook's slice already ends when the first sleeper is due - nothing is ticking, just sleep deeper
+	if (uart_idle()) _low_power_mode_3();
+	else _low_power_mode_0();
+	return;
+#endif
+
+	std::size_t ticks = os.get_next_wakeup();
+
+	// A tick already pending or due next anyway, or a transfer that needs SMCLK - stay in LPM0
+	if ((SFRIFG1 & WDTIFG) || ticks == 1 || !uart_idle()) {
+		_low_power_mode_0();	// Enables interrupts
+		return;
+	}
+
+	if (ticks == 0 || ticks > tickless_max_ticks) ticks = tickless_max_ticks;
+
+	watchdog_hold();
+
+	armed_ticks = ticks;
+	expired = false;
+	armed = true;
+
+	TB0CCR0 = static_cast<std::uint16_t>(ticks * tickless_counts_per_tick);
+	TB0CCTL0 = CCIE;
+	TB0CTL = TBSSEL_1 | ID_3 | MC_1 | TBCLR;	// ACLK / 8, up to CCR0
+
+	_low_power_mode_3();	// Enables interrupts - returns once an interrupt leaves the low power mode
+
+	/**
+	 * Back from a switch the context switch already caught up on, or woken by an interrupt that did not ask for
+	 * one - then catch up here and let the scheduler take a look, since the tick only restarts with a task load
+	 */
+
+	_disable_interrupt();
+	if (armed) {
+		os.catch_up(tickless_resume());
+		watchdog_request();
+	}
+	_enable_interrupt();
+}
+
+/**
+ * Stops the timer and works out how many whole ticks went by - the switch the wake-up requested takes none of its own
+ */
+
+std::size_t tickless_resume(void) {
+	if (!armed) return 0;
+	armed = false;
+
+	const std::uint16_t counted = TB0R;
+	TB0CTL = MC_0;
+	TB0CCTL0 = 0;
+
+	if (expired) return armed_ticks;
+	return counted / tickless_counts_per_tick;
+}
+
+/**
+ * The first sleeper is due - leave LPM3 and have the kernel switch
+ */
+
+#pragma vector = TIMER0_B0_VECTOR
+__attribute__((interrupt)) void tickless_wakeup(void) {
+	TB0CTL = MC_0;
+	expired = true;
+
+	watchdog_request();
+	_low_power_mode_off_on_exit();
+}
+
+#endif
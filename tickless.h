@@ -0,0 +1,41 @@
+/*
+ * tickless.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef TICKLESS_H_
+#define TICKLESS_H_
+
+#include <msp430.h>
+#include <config.h>
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Tickless idle. With TICKLESS_IDLE defined, the idle hook stops the watchdog tick, programs Timer_B0 from ACLK to
+ * fire when the first sleeper is due and drops into LPM3 instead of spinning through LPM0 tick after tick. Whatever
+ * wakes the CPU - the timer or an interrupt that requests a switch - the kernel first catches the tick count and the
+ * sleepers up on the time that went by, then schedules as usual. With nobody asleep at all the timer is armed for
+ * its longest interval, tickless_max_ticks.
+ *
+ * With SLICE_TIMER the tick is already gone: the idle hook's slice ends when the first sleeper is due, so Timer_B0
+ * is left alone and the idle hook only chooses the low power mode.
+ *
+ * LPM3 stops SMCLK, so the idle hook only goes that deep once the UART has nothing left to send, and falls back to
+ * LPM0 otherwise. The CPU accounting timer (cpu_time.h) stands still in LPM3 as well - its idle figure then only
+ * covers the time spent awake in the idle hook.
+ */
+
+constexpr std::uint16_t tickless_counts_per_tick = 8;	// WDT_ADLY_1_9 is 64 ACLK cycles, Timer_B0 counts ACLK / 8
+constexpr std::size_t tickless_max_ticks = 0xFFFF / tickless_counts_per_tick;
+
+// Body of the idle hook - sleeps until the first sleeper is due or something else needs the CPU
+void tickless_idle(void);
+
+// Stops the wake-up timer if it is armed and returns the ticks to catch up on - interrupts must be disabled
+std::size_t tickless_resume(void);
+
+#endif /* TICKLESS_H_ */
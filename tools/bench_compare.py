@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+#
+# bench_compare.py
+#
+#  Created on: Oct 18, 2026
+#      Author: krad2
+#
+# Compares two runs of the host benchmark suite (bench/sched_bench.cpp) and exits with status 1 when a case got
+# slower than the threshold allows, or started allocating. Cases are matched on every field that is not a result.
+# Timings only mean something between runs on the same, otherwise idle machine.
+#
+#   python3 tools/bench_compare.py baseline.json current.json [threshold percent, default 10]
+#
+
+import json
+import sys
+
+# Results where lower is better, and how much noise each one gets on top of the threshold
+TIMINGS = {'ns_mean': 1.0, 'ns_p50': 1.0, 'ns_p99': 2.0, 'ns_per_byte': 1.0, 'ns_per_call': 1.0}
+
+# Changes below this many nanoseconds are within the cost of reading the clock and never count
+NOISE_FLOOR_NS = 10.0
+
+ALLOCATIONS = ('allocs_per_decision', 'allocs_per_write', 'allocs_per_call')
+RESULTS = set(TIMINGS) | set(ALLOCATIONS) | {'ns_max', 'measured_off', 'idle_share', 'bytes', 'bytes_per_s', 'decisions', 'calls'}
+
+
+def load(path):
+	"""Maps the identifying fields of every case to its results"""
+	cases = {}
+	with open(path) as f:
+		for line in f:
+			line = line.strip()
+			if not line.startswith('{'):
+				continue
+
+			entry = json.loads(line)
+			key = tuple(sorted((k, v) for k, v in entry.items() if k not in RESULTS))
+			cases[key] = entry
+
+	return cases
+
+
+def describe(key):
+	return ' '.join('%s=%s' % (k, v) for k, v in key if k != 'suite')
+
+
+def main(argv):
+	if len(argv) < 3:
+		sys.stderr.write('usage: %s baseline.json current.json [threshold percent]\n' % argv[0])
+		return 2
+
+	baseline = load(argv[1])
+	current = load(argv[2])
+	threshold = float(argv[3]) if len(argv) > 3 else 10.0
+
+	regressions = 0
+	for key in sorted(set(baseline) & set(current)):
+		old, new = baseline[key], current[key]
+
+		for field, slack in TIMINGS.items():
+			if field not in old or field not in new or old[field] <= 0:
+				continue
+
+			change = 100.0 * (new[field] - old[field]) / old[field]
+			if change > threshold * slack and new[field] - old[field] > NOISE_FLOOR_NS * slack:
+				print('REGRESSION %s: %s %.1f -> %.1f (%+.1f%%)' % (describe(key), field, old[field], new[field], change))
+				regressions += 1
+
+		for field in ALLOCATIONS:
+			if new.get(field, 0) > old.get(field, 0):
+				print('REGRESSION %s: %s %.3f -> %.3f' % (describe(key), field, old.get(field, 0), new.get(field, 0)))
+				regressions += 1
+
+	for key in sorted(set(baseline) - set(current)):
+		print('MISSING %s' % describe(key))
+
+	print('%d cases compared, %d regressions' % (len(set(baseline) & set(current)), regressions))
+	return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+#
+# log_decode.py
+#
+#  Created on: Oct 18, 2026
+#      Author: krad2
+#
+# Host-side decoder for deferred_log.h. Rebuilds uart_log() output from the binary frames the device sends, using
+# the format strings stored in the .log_strings section of the firmware ELF. Plain ASCII between frames (e.g. from
+# uart_printf) is passed through untouched.
+#
+#   python3 tools/log_decode.py Debug/f5529_kernel.out capture.bin
+#   python3 tools/log_decode.py Debug/f5529_kernel.out < /dev/ttyACM0
+#
+
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+FRAME_HEADER = 4
+
+
+def load_format_strings(elf_path):
+	"""Maps the low 16 bits of every string's address in .log_strings to the string itself"""
+	with open(elf_path, 'rb') as f:
+		elf = f.read()
+
+	if elf[:4] != b'\x7fELF':
+		raise ValueError('%s is not an ELF file' % elf_path)
+
+	is64 = elf[4] == 2
+	endian = '<' if elf[5] == 1 else '>'
+
+	if is64:
+		shoff, = struct.unpack_from(endian + 'Q', elf, 0x28)
+		shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x3A)
+		section_fmt = endian + 'IIQQQQIIQQ'
+	else:
+		shoff, = struct.unpack_from(endian + 'I', elf, 0x20)
+		shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x2E)
+		section_fmt = endian + 'IIIIIIIIII'
+
+	sections = []
+	for i in range(shnum):
+		name, _, _, addr, offset, size = struct.unpack_from(section_fmt, elf, shoff + i * shentsize)[:6]
+		sections.append((name, addr, offset, size))
+
+	_, _, names_offset, _ = sections[shstrndx]
+
+	def section_name(name):
+		end = elf.index(b'\0', names_offset + name)
+		return elf[names_offset + name:end].decode('ascii', 'replace')
+
+	formats = {}
+	for name, addr, offset, size in sections:
+		if section_name(name) != '.log_strings':
+			continue
+
+		data = elf[offset:offset + size]
+		pos = 0
+		while pos < len(data):
+			end = data.find(b'\0', pos)
+			if end < 0:
+				end = len(data)
+			if end > pos:
+				formats[(addr + pos) & 0xFFFF] = data[pos:end].decode('ascii', 'replace')
+			pos = end + 1
+
+	return formats
+
+
+def render(fmt, payload):
+	"""Formats a payload the way uart_printf would have, following its conversion specifiers"""
+	out = []
+	pos = 0
+	it = iter(range(len(fmt)))
+
+	for i in it:
+		c = fmt[i]
+		if c != '%' or i + 1 >= len(fmt):
+			out.append(c)
+			continue
+
+		spec = fmt[i + 1]
+		next(it, None)
+
+		if spec == 'c':
+			out.append(chr(payload[pos]))
+			pos += 1
+		elif spec in 'iux':
+			value, = struct.unpack_from('<h' if spec == 'i' else '<H', payload, pos)
+			pos += 2
+			out.append('%04X' % value if spec == 'x' else str(value))
+		elif spec in 'ln':
+			value, = struct.unpack_from('<i' if spec == 'l' else '<I', payload, pos)
+			pos += 4
+			out.append(str(value))
+		elif spec == 's':
+			length = payload[pos]
+			out.append(payload[pos + 1:pos + 1 + length].decode('ascii', 'replace'))
+			pos += 1 + length
+		else:
+			out.append(c + spec)
+
+	return ''.join(out)
+
+
+def decode(stream, formats, write):
+	"""Splits a byte stream into text and frames, writing out the decoded text"""
+	buf = b''
+
+	while True:
+		chunk = stream.read(4096)
+		if not chunk:
+			break
+		buf += chunk
+
+		while buf:
+			if buf[0] != FRAME_SYNC:
+				if buf[0] < 0x80:
+					write(chr(buf[0]))
+				buf = buf[1:]
+				continue
+
+			if len(buf) < FRAME_HEADER or len(buf) < FRAME_HEADER + buf[3]:
+				break	# Wait for the rest of the frame
+
+			frame_id = buf[1] | (buf[2] << 8)
+			payload = buf[FRAME_HEADER:FRAME_HEADER + buf[3]]
+			buf = buf[FRAME_HEADER + buf[3]:]
+
+			fmt = formats.get(frame_id)
+			if fmt is None:
+				write('<unknown log id 0x%04X>\n' % frame_id)
+				continue
+
+			try:
+				write(render(fmt, payload))
+			except (IndexError, struct.error):
+				write('<malformed frame for "%s">\n' % fmt.strip())
+
+
+def main(argv):
+	if len(argv) < 2:
+		sys.stderr.write('usage: %s firmware.out [capture.bin]\n' % argv[0])
+		return 1
+
+	formats = load_format_strings(argv[1])
+	stream = open(argv[2], 'rb') if len(argv) > 2 else sys.stdin.buffer
+
+	decode(stream, formats, lambda s: (sys.stdout.write(s), sys.stdout.flush()))
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))
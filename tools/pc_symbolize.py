@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+#
+# pc_symbolize.py
+#
+#  Created on: Oct 18, 2026
+#      Author: krad2
+#
+# Host-side report for pc_sample.h. Maps the "pc <tid> <address>" lines printed by pc_sample_dump() to functions
+# from the symbol table of the firmware ELF and prints where each task spends its CPU time. Any other output on the
+# line (e.g. from uart_printf) is skipped, and samples from several dumps add up.
+#
+#   python3 tools/pc_symbolize.py Debug/f5529_kernel.out capture.txt [functions per task, default 10]
+#   python3 tools/pc_symbolize.py Debug/f5529_kernel.out < /dev/ttyACM0
+#
+
+import bisect
+import collections
+import shutil
+import struct
+import subprocess
+import sys
+
+SHT_SYMTAB = 2
+STT_NOTYPE = 0
+STT_FUNC = 2
+
+
+def load_symbols(elf_path):
+	"""Returns the code symbols of an ELF as a sorted list of (address, size, name)"""
+	with open(elf_path, 'rb') as f:
+		elf = f.read()
+
+	if elf[:4] != b'\x7fELF':
+		raise ValueError('%s is not an ELF file' % elf_path)
+
+	is64 = elf[4] == 2
+	endian = '<' if elf[5] == 1 else '>'
+
+	if is64:
+		shoff, = struct.unpack_from(endian + 'Q', elf, 0x28)
+		shentsize, shnum = struct.unpack_from(endian + 'HH', elf, 0x3A)
+		section_fmt = endian + 'IIQQQQIIQQ'
+	else:
+		shoff, = struct.unpack_from(endian + 'I', elf, 0x20)
+		shentsize, shnum = struct.unpack_from(endian + 'HH', elf, 0x2E)
+		section_fmt = endian + 'IIIIIIIIII'
+
+	sections = [struct.unpack_from(section_fmt, elf, shoff + i * shentsize) for i in range(shnum)]
+
+	symbols = []
+	for _, sh_type, _, _, offset, size, link, _, _, entsize in sections:
+		if sh_type != SHT_SYMTAB:
+			continue
+
+		strtab_offset = sections[link][4]
+		for pos in range(offset, offset + size, entsize):
+			if is64:
+				name, info, _, shndx, value, sym_size = struct.unpack_from(endian + 'IBBHQQ', elf, pos)
+			else:
+				name, value, sym_size, info, _, shndx = struct.unpack_from(endian + 'IIIBBH', elf, pos)
+
+			# Functions, and plain labels inside a section (assembly routines such as ctx_save)
+			kind = info & 0xF
+			if shndx == 0 or shndx >= 0xFF00 or kind not in (STT_FUNC, STT_NOTYPE):
+				continue
+
+			end = elf.index(b'\0', strtab_offset + name)
+			label = elf[strtab_offset + name:end].decode('ascii', 'replace')
+			if not label or label.startswith(('$', '.L')):
+				continue
+
+			symbols.append((value, sym_size if kind == STT_FUNC else 0, label))
+
+	symbols.sort()
+	return symbols
+
+
+def demangle(names):
+	"""Demangles C++ names with whichever c++filt is around, leaves them as they are otherwise"""
+	tool = shutil.which('msp430-elf-c++filt') or shutil.which('c++filt')
+	if tool is None or not names:
+		return {n: n for n in names}
+
+	result = subprocess.run([tool], input='\n'.join(names), stdout=subprocess.PIPE, universal_newlines=True)
+	return dict(zip(names, result.stdout.splitlines()))
+
+
+def symbolize(symbols, pc):
+	"""Name of the function holding pc - the closest symbol below it, unless that one has a size that ends short"""
+	i = bisect.bisect_right(symbols, (pc, float('inf'), '')) - 1
+	if i < 0:
+		return '<0x%X>' % pc
+
+	address, size, name = symbols[i]
+	if size and pc >= address + size:
+		return '<0x%X>' % pc
+
+	return name
+
+
+def read_samples(stream):
+	samples = []
+	dropped = 0
+
+	for line in stream:
+		fields = line.split()
+		if len(fields) != 3 or fields[0] != 'pc':
+			continue
+
+		if fields[1] == 'dropped':
+			dropped = max(dropped, int(fields[2]))
+			continue
+
+		try:
+			samples.append((int(fields[1]), int(fields[2], 0)))
+		except ValueError:
+			continue
+
+	return samples, dropped
+
+
+def report(samples, dropped, symbols, top):
+	by_function = collections.Counter()
+	by_task = collections.defaultdict(collections.Counter)
+
+	for tid, pc in samples:
+		name = symbolize(symbols, pc)
+		by_function[name] += 1
+		by_task[tid][name] += 1
+
+	names = demangle(list(by_function))
+	total = len(samples)
+
+	print('%d samples, %d dropped' % (total, dropped))
+	if total == 0:
+		return
+
+	print('\nall tasks')
+	for name, count in by_function.most_common(top):
+		print('  %6.2f%%  %6d  %s' % (100.0 * count / total, count, names[name]))
+
+	for tid in sorted(by_task, key=lambda t: -sum(by_task[t].values())):
+		functions = by_task[tid]
+		task_total = sum(functions.values())
+
+		print('\ntask %d: %.2f%% of samples' % (tid, 100.0 * task_total / total))
+		for name, count in functions.most_common(top):
+			print('  %6.2f%%  %6d  %s' % (100.0 * count / task_total, count, names[name]))
+
+
+def main(argv):
+	if len(argv) < 2:
+		sys.stderr.write('usage: %s firmware.elf [capture.txt] [functions per task]\n' % argv[0])
+		return 2
+
+	symbols = load_symbols(argv[1])
+	top = int(argv[3]) if len(argv) > 3 else 10
+
+	if len(argv) > 2 and argv[2] != '-':
+		with open(argv[2], errors='replace') as f:
+			samples, dropped = read_samples(f)
+	else:
+		samples, dropped = read_samples(sys.stdin)
+
+	report(samples, dropped, symbols, top)
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))
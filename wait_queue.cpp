@@ -0,0 +1,42 @@
+/*
+ * wait_queue.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#include <wait_queue.h>
+
+/**
+ * Default constructor
+ */
+
+wait_queue::wait_queue() : head(nullptr), tail(nullptr) { }
+
+/**
+ * Appends a blocked task at the tail
+ */
+
+void wait_queue::push(task &t) {
+	t.link.next = nullptr;
+
+	if (this->tail != nullptr) this->tail->link.next = &t;
+	else this->head = &t;
+
+	this->tail = &t;
+}
+
+/**
+ * Unlinks the head of the queue
+ */
+
+task *wait_queue::pop(void) {
+	task *t = this->head;
+	if (t == nullptr) return nullptr;
+
+	this->head = t->link.next;
+	if (this->head == nullptr) this->tail = nullptr;
+
+	t->link.next = nullptr;
+	return t;
+}
@@ -0,0 +1,40 @@
+/*
+ * wait_queue.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: krad2
+ */
+
+#ifndef WAIT_QUEUE_H_
+#define WAIT_QUEUE_H_
+
+#include <task.h>
+
+/**
+ * FIFO of tasks blocked on some event (e.g. room in a driver buffer). Tasks are chained through link.next, which is
+ * free while they are blocked, so waiting costs no memory and both ends are O(1). A task waits on one queue at a
+ * time; the scheduler's wait() and notify_one() / notify_all() do the blocking and unblocking.
+ */
+
+class wait_queue {
+public:
+	wait_queue();
+
+	// Appends a blocked task
+	void push(task &t);
+
+	// Takes the longest waiting task off the queue, or nullptr if nobody waits
+	task *pop(void);
+
+	inline bool empty(void) const;
+
+private:
+	task *head;
+	task *tail;
+};
+
+inline bool wait_queue::empty(void) const {
+	return (this->head == nullptr);
+}
+
+#endif /* WAIT_QUEUE_H_ */
@@ -7,21 +7,51 @@
 
 #include <watchdog.h>
 
+#ifdef SLICE_TIMER
+// Timer_A0 ends the slices - the watchdog is held in interval mode and only carries requested switches
+#define WDT_SLICE (WDTPW | WDTHOLD | WDTTMSEL)
+#define WDT_RUN WDT_SLICE
+#else
+#define WDT_SLICE WDT_ADLY_1_9
+#define WDT_RUN (WDT_ADLY_1_9 & ~WDTCNTCL)	// Leaves the count alone, so the interval keeps real time across switches
+#endif
+
+static volatile bool requested = false;	// WDTIFG was raised by the kernel rather than by the interval
+
 // Configure the scheduler timer interrupt
 void watchdog_init(void) {
-	WDTCTL = WDT_ADLY_1_9;
+	WDTCTL = WDT_SLICE;
 	SFRIE1 |= WDTIE;
 }
 
 // Set preemption flag and wait for interrupts
 void watchdog_request(void) {
+	if (!(SFRIFG1 & WDTIFG)) requested = true;	// An interval already run out carries the switch as a tick
 	SFRIFG1 |= WDTIFG;
 }
 
-// Disable watchdog because it must be reloaded upon the end of a context switch
+// Restart the watchdog if it was held at the end of a context switch. A request made while the kernel ran has been
+// served by this switch, but an interval that ran out meanwhile is a tick still to be taken
 void watchdog_reload(void) {
-	SFRIFG1 &= ~WDTIFG;
-	WDTCTL = WDT_ADLY_1_9;
+	if (requested) {
+		SFRIFG1 &= ~WDTIFG;
+		requested = false;
+	}
+	WDTCTL = WDT_RUN;
+}
+
+// Stop the interval timer - the next reload starts it again. Interval mode stays selected, or WDTIE would no
+// longer let requested switches through
+void watchdog_hold(void) {
+	WDTCTL = WDTPW | WDTHOLD | WDTTMSEL;
+}
+
+// Whether the watchdog interrupt being taken is a tick rather than a requested switch - only ticks advance kernel
+// time. Called on entry to the switch with interrupts disabled
+bool watchdog_ticked(void) {
+	const bool ticked = !requested;
+	requested = false;
+	return ticked;
 }
 
 void wdt_reload(void) {
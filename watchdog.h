@@ -14,6 +14,8 @@
 void watchdog_init(void);
 void watchdog_request(void);
 void watchdog_reload(void);
+void watchdog_hold(void);
+bool watchdog_ticked(void);
 
 extern "C" void wdt_reload(void);
 